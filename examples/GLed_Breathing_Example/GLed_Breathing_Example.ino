@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       LED control
+//
+//  Subcomponent:  ESP32 Led control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       led control
+// premises:
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLed_Breathing_Example.ino
+// language:       C++
+// compiler:       g++ (i.e. Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+
+# include <Arduino.h>
+
+# include <GLed.h>
+
+int led_gpio_num                              = 18;                  // <<< ADJUST according to your board.
+GLed::gled_switching_logic_t  switching_logic = GLed::LOW_IS_ACTIVE;  // <<< ADJUST according to your board, else the on/off commands are interchanged.
+
+GLed gled( led_gpio_num, switching_logic );
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(300);
+
+  Serial.println( "BOOTING GLED Example - LED breathing" );
+  Serial.printf( "  expect that the LED is controlled with pin %d \n", gled.get_pin() );
+
+  // activate the pin port for the GLed control.
+  gled.begin();
+}
+
+void loop()
+{
+  Serial.println( "the LED schould now be breathing slowly for 10 seconds." );
+  gled.breathe( 4000 );
+  delay(10000);
+
+  Serial.println( "the LED schould now be breathing fast and never go dark for 10 seconds." );
+  gled.breathe( 1000, 40, 255 );
+  delay(10000);
+
+  Serial.println( "the LED flashes now 5 times, this ends the breathing." );
+  gled.flash(5);
+  gled.off();
+  delay(3000);
+
+  Serial.println();
+}
+
+// eof
@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       LED control
+//
+//  Subcomponent:  ESP32 Led control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       led control
+// premises:       ESP32-S2, ESP32-S3 or ESP32-C3 for the dedicated gpios.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLed_Group_Example.ino
+// language:       C++
+// compiler:       g++ (i.e. Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+
+# include <Arduino.h>
+
+# include <GLed.h>
+# include <GLedGroup.h>
+
+// four LEDs and a marker pin for a logic analyzer.
+const int pins[] = { 1, 2, 3, 4, 5 };                                   // <<< ADJUST according to your board.
+const unsigned MARKER = 4;                                              // channel of the marker pin.
+
+GLedGroup group( pins, 5 );
+GLed running( group, 0 ), status( group, 1 );
+
+const int ROUNDS = 1000;
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(300);
+
+  Serial.println( "BOOTING GLED Example - LEDs on dedicated gpios" );
+
+  // the bundle belongs to the core of the loop task.
+  if( group.begin() != ESP_OK )
+    Serial.println( "the dedicated gpio bundle could not be created." );
+
+  running.begin();
+  status.begin();
+  running.async_flash( GLed::FLASH_FOR_EVER, 50, 950 );
+}
+
+void loop()
+{
+  uint32_t start, frame_cycles, digital_cycles;
+
+  // the frame write: the LEDs 2 and 3 alternate.
+  group.pulse( 1u << MARKER );
+  start = ESP.getCycleCount();
+  for( int i = 0; i < ROUNDS; i++ )
+    group.write_frame( i & 1 ? 0x4 : 0x8, 0xc );
+  frame_cycles = ESP.getCycleCount() - start;
+  group.pulse( 1u << MARKER );
+
+  // the same frames by digitalWrite(), for comparison only:
+  // the pins stay connected to the bundle, so the LEDs do not change here.
+  start = ESP.getCycleCount();
+  for( int i = 0; i < ROUNDS; i++ ) {
+    digitalWrite( pins[2], i & 1 ? HIGH : LOW );
+    digitalWrite( pins[3], i & 1 ? LOW : HIGH );
+  }
+  digital_cycles = ESP.getCycleCount() - start;
+  group.write_frame( 0, 0xc );
+
+  Serial.printf( "cpu cycles per frame: write_frame() %u, digitalWrite() %u\n",
+                 frame_cycles / ROUNDS, digital_cycles / ROUNDS );
+  Serial.printf( "%u writes handed over to the core of the bundle\n", group.get_deferred() );
+
+  status.toggle();
+  delay(3000);
+}
+
+// eof
@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       LED control
+//
+//  Subcomponent:  ESP32 Led control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       led control
+// premises:
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLed_ShiftRegister_Example.ino
+// language:       C++
+// compiler:       g++ (i.e. Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+
+# include <Arduino.h>
+
+# include <GLed.h>
+# include <GLedShiftRegister.h>
+
+// two 74HC595 in a chain: MOSI -> SER, SCLK -> SRCLK, CS -> RCLK of both.
+GLedShiftRegister chain( SPI2_HOST, 23, 18, 5, 16 );                  // <<< ADJUST according to your board.
+
+// LEDs on the outputs Q0, Q1 of the first and Q7 of the second register.
+GLed heartbeat( chain, 0 ), status( chain, 1 ), error( chain, 15 );
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(300);
+
+  Serial.println( "BOOTING GLED Example - LEDs on shift registers" );
+
+  if( chain.begin() != ESP_OK )
+    Serial.println( "the SPI bus could not be initialized." );
+
+  heartbeat.begin();
+  status.begin();
+  error.begin();
+
+  heartbeat.async_flash( GLed::FLASH_FOR_EVER, 50, 950 );
+}
+
+void loop()
+{
+  Serial.println( "the status LED schould now toggle, the error LED flash 3 times." );
+  status.toggle();
+  error.async_flash( 3, 100, 200 );
+  delay(3000);
+
+  Serial.printf( "%u frames sent\n", chain.get_transfers() );
+}
+
+// eof
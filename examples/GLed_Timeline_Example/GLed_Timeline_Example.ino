@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       LED control
+//
+//  Subcomponent:  ESP32 Led control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       led control
+// premises:
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLed_Timeline_Example.ino
+// language:       C++
+// compiler:       g++ (i.e. Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+
+# include <Arduino.h>
+
+# include <GLed.h>
+# include <GLedTimeline.h>
+
+// a row of LEDs, switched on by a HIGH level.
+GLed led_1(16), led_2(17), led_3(18), led_4(19), led_5(21);           // <<< ADJUST according to your board.
+GLed * leds[] = { &led_1, &led_2, &led_3, &led_4, &led_5 };
+const int n_leds = sizeof(leds) / sizeof(leds[0]);
+const unsigned step_time = 100;                                       // [ms]
+
+// knight rider: the light runs forth and back, one period is 2*(n_leds-1) steps.
+GLedTimeline knight_rider( 2 * (n_leds - 1) * step_time );
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(300);
+
+  Serial.println( "BOOTING GLED Example - LED timeline" );
+
+  for( int i = 0; i < n_leds; i++ ) {
+    leds[i]->begin();
+    int track = knight_rider.add_track( *leds[i] );
+
+    knight_rider.add_pulse( track, i * step_time, step_time );                            // forth
+    if( i > 0 && i < n_leds - 1 )
+      knight_rider.add_pulse( track, (2 * (n_leds - 1) - i) * step_time, step_time );     // and back
+  }
+}
+
+void loop()
+{
+  Serial.println( "the LEDs schould now run forth and back 10 times." );
+  knight_rider.start( 10 );
+  delay( 10 * knight_rider.get_period() + 1000 );
+
+  Serial.println( "the LEDs schould now run for ever, until stopped after 5 seconds." );
+  knight_rider.start();
+  delay(5000);
+  knight_rider.stop();
+  for( int i = 0; i < n_leds; i++ )
+    leds[i]->off();
+  delay(2000);
+
+  Serial.println();
+}
+
+// eof
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       register model of a MCP23017/PCA9555 for host builds.
+// premises:	   host compiler, no hardware.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMockExpander.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_MOCK_EXPANDER_HEADER_H
+#define GLED_MOCK_EXPANDER_HEADER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "GLedExpander.h"
+
+/**
+ * The GLedMockExpander models the registers of an expander on the host.
+ * It takes the place of the I2C bus of a GLedExpander, decodes the register writes
+ * like the device would and counts the bus transactions and the bus time.
+ * \n
+ * Example:
+ * \code
+ * GLedMockExpander mock( GLedExpander::MCP23017, 0x20 );
+ * GLedExpander expander( GLedExpander::MCP23017, 0x20, GLedMockExpander::bus_write, &mock );
+ * GLed led( expander, 3 );
+ *
+ * led.begin();
+ * led.on();
+ * expander.flush();
+ * // mock.get_output( 3 ) == true, mock.get_transactions() == 2
+ * \endcode
+ */
+class GLedMockExpander {
+public:
+    static const int DEFAULT_BUS_CLOCK = 100000;   ///< I2C clock used by get_bus_time() [Hz]
+
+    GLedMockExpander( GLedExpander::chip_t a_chip, uint8_t a_address )
+        : chip(a_chip)
+        , address(a_address)
+        , transactions(0)
+        , bytes(0)
+        , failures(0)
+    {
+        reset();
+    }
+
+    /**
+     * set the registers to their power on values: all pins are inputs, latches are 0 (MCP23017) or 1 (PCA9555).
+     */
+    void reset()
+    {
+        memset( reg, 0, sizeof(reg) );
+        if( chip == GLedExpander::MCP23017 )
+            reg[0x00] = reg[0x01] = 0xff;    // IODIRA, IODIRB
+        else
+            reg[0x02] = reg[0x03] = reg[0x06] = reg[0x07] = 0xff;
+    }
+
+    /**
+     * bus write function of the GLedExpander, ctx is the mock.
+     * @return ESP_OK, or ESP_FAIL (NACK) if the address does not match or a failure is pending, see fail().
+     */
+    static esp_err_t bus_write( void *ctx, uint8_t a_address, const uint8_t *data, size_t len )
+    {
+        GLedMockExpander * mock = (GLedMockExpander*) ctx;
+
+        mock->transactions++;
+        mock->bytes += 1 + len;   // address byte and data.
+        if( a_address != mock->address || len == 0 )
+            return ESP_FAIL;
+        if( mock->failures > 0 ) {   // a disturbed bus, the registers keep their values.
+            mock->failures--;
+            return ESP_FAIL;
+        }
+
+        // the register pointer increments with each byte, the PCA9555 toggles within a register pair:
+        uint8_t r = data[0];
+        for( size_t i = 1; i < len; i++ ) {
+            mock->reg[r & 0x1f] = data[i];
+            r = mock->chip == GLedExpander::MCP23017 ? r + 1 : r ^ 1;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * get the level of a pin, an input reads as LOW.
+     */
+    bool get_output( unsigned n ) const { return (get_outputs() >> n) & 1; }
+
+    /**
+     * get the levels of all output pins, bit n for pin n.
+     */
+    uint16_t get_outputs() const
+    {
+        const uint16_t direction = chip == GLedExpander::MCP23017 ? reg16( 0x00 ) : reg16( 0x06 );
+        const uint16_t latch = chip == GLedExpander::MCP23017 ? reg16( 0x14 ) : reg16( 0x02 );
+        return latch & ~direction;
+    }
+
+    /**
+     * get a register value.
+     */
+    uint8_t get_register( uint8_t r ) const { return reg[r & 0x1f]; }
+
+    unsigned get_transactions() const { return transactions; }   ///< number of bus transactions.
+
+    /**
+     * get the time the bus was busy: 9 clocks per byte plus start and stop.
+     * @param clock: I2C clock [Hz]
+     * @return bus time [us]
+     */
+    unsigned long get_bus_time( int clock = DEFAULT_BUS_CLOCK ) const
+    {
+        return (unsigned long) ((bytes * 9ull + transactions * 2ull) * 1000000ull / clock);
+    }
+
+    /**
+     * let the next transactions fail, like a disturbed bus.
+     * @param count: number of transactions answered by a NACK.
+     */
+    void fail( unsigned count ) { failures = count; }
+
+    /**
+     * clear the transaction counters, the registers keep their values.
+     */
+    void clear_counters() { transactions = 0; bytes = 0; }
+
+private:
+    GLedExpander::chip_t chip;
+    uint8_t address;
+    uint8_t reg[32];
+    unsigned transactions;
+    unsigned long bytes;
+    unsigned failures;                ///< transactions still to fail, see fail().
+
+    uint16_t reg16( uint8_t r ) const { return reg[r] | (reg[r + 1] << 8); }
+};
+
+#endif
+
+// eof
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       register model of a PCA9685 for host builds.
+// premises:	   host compiler, no hardware.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMockPCA9685.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_MOCK_PCA9685_HEADER_H
+#define GLED_MOCK_PCA9685_HEADER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "GLedPCA9685.h"
+
+/**
+ * The GLedMockPCA9685 models the registers of a PCA9685 on the host.
+ * It takes the place of the I2C bus of a GLedPCA9685, decodes the register writes
+ * with auto increment like the device and counts the bus transactions and the bus time.
+ * \n
+ * Example:
+ * \code
+ * GLedMockPCA9685 mock( 0x40 );
+ * GLedPCA9685 pwm( 0x40, GLedMockPCA9685::bus_write, &mock );
+ * GLed led( pwm, 5 );
+ *
+ * pwm.begin();
+ * led.begin();
+ * led.set_brightness( 128 );
+ * pwm.flush();
+ * // mock.get_duty( 5 ) == 2056
+ * \endcode
+ */
+class GLedMockPCA9685 {
+public:
+    static const int DEFAULT_BUS_CLOCK = 400000;   ///< I2C clock used by get_bus_time() [Hz]
+
+    GLedMockPCA9685( uint8_t a_address )
+        : address(a_address)
+        , transactions(0)
+        , bytes(0)
+        , failures(0)
+    {
+        reset();
+    }
+
+    /**
+     * set the registers to their power on values: sleep mode, all outputs full off.
+     */
+    void reset()
+    {
+        memset( reg, 0, sizeof(reg) );
+        reg[0x00] = 0x11;                  // MODE1: SLEEP, ALLCALL
+        reg[0x01] = 0x04;                  // MODE2: OUTDRV
+        for( int i = 0; i < 16; i++ )
+            reg[0x09 + 4 * i] = 0x10;      // LEDn_OFF_H: full off
+        reg[0xfe] = 0x1e;                  // PRE_SCALE: 200 Hz
+    }
+
+    /**
+     * bus write function of the GLedPCA9685, ctx is the mock.
+     * @return ESP_OK, or ESP_FAIL (NACK) if the address does not match or a failure is pending, see fail().
+     */
+    static esp_err_t bus_write( void *ctx, uint8_t a_address, const uint8_t *data, size_t len )
+    {
+        GLedMockPCA9685 * mock = (GLedMockPCA9685*) ctx;
+
+        mock->transactions++;
+        mock->bytes += 1 + len;   // address byte and data.
+        if( a_address != mock->address || len == 0 )
+            return ESP_FAIL;
+        if( mock->failures > 0 ) {   // a disturbed bus, the registers keep their values.
+            mock->failures--;
+            return ESP_FAIL;
+        }
+
+        uint8_t r = data[0];
+        for( size_t i = 1; i < len; i++ ) {
+            if( r == 0xfe && ! (mock->reg[0x00] & 0x10) ) {   // PRE_SCALE is write protected unless sleeping.
+                r++;
+                continue;
+            }
+            if( r >= 0xfa && r <= 0xfd ) {   // ALL_LED registers load the registers of all outputs.
+                for( int n = 0; n < 16; n++ )
+                    mock->reg[0x06 + 4 * n + (r - 0xfa)] = data[i];
+            }
+            else if( r != 0xff )   // TestMode
+                mock->reg[r] = data[i];
+            if( mock->reg[0x00] & 0x20 )   // auto increment, the LED registers wrap to MODE1.
+                r = r == 0x45 ? 0x00 : r + 1;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * get the on time of an output.
+     * @return 0 (full off) .. 4096 (full on).
+     */
+    unsigned get_duty( unsigned n ) const
+    {
+        const unsigned on = get_on( n );
+        const unsigned off = get_off( n );
+
+        if( off & 0x1000 )   // full off wins over full on.
+            return 0;
+        if( on & 0x1000 )
+            return 4096;
+        return (off - on) & 0xfff;
+    }
+
+    /**
+     * get the level of an output at a time of the PWM period.
+     * @param n: output.
+     * @param t: counter value 0..4095.
+     */
+    bool get_output( unsigned n, unsigned t ) const
+    {
+        const unsigned duty = get_duty( n );
+        const unsigned on = get_on( n ) & 0xfff;
+
+        if( duty == 0 || duty == 4096 )
+            return duty != 0;
+        return ((t - on) & 0xfff) < duty;
+    }
+
+    /**
+     * get the PWM frequency set by the prescaler.
+     */
+    int get_frequency() const { return 25000000 / (4096 * (reg[0xfe] + 1)); }
+
+    /**
+     * check if the oscillator runs.
+     */
+    bool is_running() const { return ! (reg[0x00] & 0x10); }
+
+    uint8_t get_register( uint8_t r ) const { return reg[r]; }     ///< get a register value.
+    unsigned get_transactions() const { return transactions; }      ///< number of bus transactions.
+
+    /**
+     * get the time the bus was busy: 9 clocks per byte plus start and stop.
+     * @param clock: I2C clock [Hz]
+     * @return bus time [us]
+     */
+    unsigned long get_bus_time( int clock = DEFAULT_BUS_CLOCK ) const
+    {
+        return (unsigned long) ((bytes * 9ull + transactions * 2ull) * 1000000ull / clock);
+    }
+
+    /**
+     * let the next transactions fail, like a disturbed bus.
+     * @param count: number of transactions answered by a NACK.
+     */
+    void fail( unsigned count ) { failures = count; }
+
+    /**
+     * clear the transaction counters, the registers keep their values.
+     */
+    void clear_counters() { transactions = 0; bytes = 0; }
+
+private:
+    uint8_t address;
+    uint8_t reg[256];
+    unsigned transactions;
+    unsigned long bytes;
+    unsigned failures;                ///< transactions still to fail, see fail().
+
+    unsigned get_on( unsigned n ) const { return reg[0x06 + 4 * n] | (reg[0x07 + 4 * n] << 8); }
+    unsigned get_off( unsigned n ) const { return reg[0x08 + 4 * n] | (reg[0x09 + 4 * n] << 8); }
+};
+
+#endif
+
+// eof
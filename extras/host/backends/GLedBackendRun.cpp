@@ -0,0 +1,245 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs of the I2C backends against the mock devices on the host.
+// premises:	   host compiler, see extras/host/sim/GLedSim.h.
+// remarks:        build and run from the root of the library:
+//                 g++ -std=gnu++17 -Iextras/host/sim -Iextras/host -Isrc -o gled_backends extras/host/backends/GLedBackendRun.cpp
+//                     src/GLed.cpp src/GLedPattern.cpp src/GLedGpio.cpp src/GLedExpander.cpp src/GLedPCA9685.cpp
+//                     extras/host/sim/GLedSim.cpp -lpthread
+//                 ./gled_backends               exit code 1 if a check fails.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedBackendRun.cpp
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLed.h"
+#include "GLedExpander.h"
+#include "GLedMockExpander.h"
+#include "GLedMockPCA9685.h"
+#include "GLedPCA9685.h"
+#include "GLedSim.h"
+
+static const uint8_t EXPANDER_ADDRESS = 0x20;
+static const uint8_t PCA9685_ADDRESS = 0x40;
+static const unsigned CHANNEL = 3;
+
+typedef struct {
+	const char * name;
+	bool (*run)();
+} scenario_t;
+
+static bool check( bool condition, const char *what )
+{
+	if( ! condition )
+		printf( "\n  %s", what );
+	return condition;
+}
+
+// count the flashes of an output by polling it each tick.
+template<class mock_t>
+static unsigned count_flashes( const mock_t & mock, unsigned channel, uint64_t us )
+{
+	unsigned flashes = 0;
+	bool level = mock.get_output( channel );
+
+	for( uint64_t t = 0; t < us; t += 1000 * portTICK_PERIOD_MS ) {
+		GLedSim::run_for( 1000 * portTICK_PERIOD_MS );
+		if( mock.get_output( channel ) != level ) {
+			level = ! level;
+			if( level )
+				flashes++;
+		}
+	}
+	return flashes;
+}
+
+// an async_flash() of an expander LED reaches the output pin, each change in one transaction.
+static bool expander_async_flash()
+{
+	GLedMockExpander mock( GLedExpander::MCP23017, EXPANDER_ADDRESS );
+	GLedExpander expander( GLedExpander::MCP23017, EXPANDER_ADDRESS, GLedMockExpander::bus_write, &mock );
+	GLed led( expander, CHANNEL );
+	bool ok = true;
+
+	expander.begin();
+	led.begin();
+	GLedSim::run_for( 10000 );
+	ok &= check( ! mock.get_output( CHANNEL ) && (mock.get_register( 0x00 ) & (1u << CHANNEL)) == 0, "output not configured after begin()" );
+
+	led.on();
+	GLedSim::run_for( 10000 );
+	ok &= check( mock.get_output( CHANNEL ), "output not on after on()" );
+
+	mock.clear_counters();
+	led.async_flash( 3, 100, 100 );
+	ok &= check( count_flashes( mock, CHANNEL, 1000000 ) == 3, "not 3 flashes by async_flash( 3 )" );
+	ok &= check( mock.get_output( CHANNEL ), "level before async_flash() not restored" );
+	ok &= check( mock.get_transactions() == 6, "not one transaction per edge" );
+
+	led.end();
+	expander.end();
+	ok &= check( ! mock.get_output( CHANNEL ), "output not off after end()" );
+	return ok;
+}
+
+// a failed transfer is repeated by the transfer task without a further change.
+static bool expander_bus_error()
+{
+	GLedMockExpander mock( GLedExpander::PCA9555, EXPANDER_ADDRESS );
+	GLedExpander expander( GLedExpander::PCA9555, EXPANDER_ADDRESS, GLedMockExpander::bus_write, &mock );
+	GLed led( expander, CHANNEL );
+	bool ok = true;
+
+	expander.begin();
+	led.begin();
+	GLedSim::run_for( 10000 );
+
+	mock.fail( 2 );
+	led.on();
+	GLedSim::run_for( 3 * GLED_EXPANDER_RETRY_MS * 1000 );
+	ok &= check( expander.get_errors() == 2, "not 2 bus errors" );
+	ok &= check( mock.get_output( CHANNEL ), "output not on after the bus errors" );
+
+	led.end();
+	expander.end();
+	return ok;
+}
+
+// without the transfer task flush() reports the error and sends the changes again.
+static bool expander_flush()
+{
+	GLedMockExpander mock( GLedExpander::MCP23017, EXPANDER_ADDRESS );
+	GLedExpander expander( GLedExpander::MCP23017, EXPANDER_ADDRESS, GLedMockExpander::bus_write, &mock );
+	GLed led( expander, CHANNEL );
+	bool ok = true;
+
+	led.begin();
+	ok &= check( expander.flush() == ESP_OK, "flush() after begin() failed" );
+
+	mock.fail( 1 );
+	led.on();
+	ok &= check( expander.flush() != ESP_OK, "bus error not reported by flush()" );
+	ok &= check( ! mock.get_output( CHANNEL ), "output on after a bus error" );
+	ok &= check( expander.flush() == ESP_OK && mock.get_output( CHANNEL ), "output not on after the next flush()" );
+
+	led.end();
+	expander.flush();
+	return ok;
+}
+
+// the duty of set_brightness(), on() and off() reaches the PWM registers.
+static bool pca9685_brightness()
+{
+	GLedMockPCA9685 mock( PCA9685_ADDRESS );
+	GLedPCA9685 pwm( PCA9685_ADDRESS, GLedMockPCA9685::bus_write, &mock );
+	GLed led( pwm, CHANNEL );
+	bool ok = true;
+
+	ok &= check( pwm.begin() == ESP_OK && mock.is_running(), "device not started by begin()" );
+	led.begin();
+	led.set_brightness( 128 );
+	GLedSim::run_for( 10000 );
+	ok &= check( mock.get_duty( CHANNEL ) == 2056, "duty of set_brightness( 128 ) not 2056" );
+	led.on();
+	GLedSim::run_for( 10000 );
+	ok &= check( mock.get_duty( CHANNEL ) == GLedPCA9685::MAX_DUTY, "output not full on after on()" );
+	led.off();
+	GLedSim::run_for( 10000 );
+	ok &= check( mock.get_duty( CHANNEL ) == 0, "output not full off after off()" );
+
+	led.end();
+	pwm.end();
+	return ok;
+}
+
+// breathe() is faded by the frame task, from off to full on and back.
+static bool pca9685_breathe()
+{
+	GLedMockPCA9685 mock( PCA9685_ADDRESS );
+	GLedPCA9685 pwm( PCA9685_ADDRESS, GLedMockPCA9685::bus_write, &mock );
+	GLed led( pwm, CHANNEL );
+	unsigned min = GLedPCA9685::MAX_DUTY, max = 0;
+	bool ok = true;
+
+	pwm.begin();
+	led.begin();
+	mock.clear_counters();
+	led.breathe( 1000, 0, 255 );
+	for( unsigned t = 0; t < 1000; t += GLED_PCA9685_FRAME_TIME ) {
+		GLedSim::run_for( GLED_PCA9685_FRAME_TIME * 1000 );
+		const unsigned duty = mock.get_duty( CHANNEL );
+		min = duty < min ? duty : min;
+		max = duty > max ? duty : max;
+	}
+	ok &= check( min < GLedPCA9685::MAX_DUTY / 8 && max > GLedPCA9685::MAX_DUTY * 7 / 8, "breathe() does not fade over the full range" );
+	ok &= check( mock.get_transactions() <= 1000 / GLED_PCA9685_FRAME_TIME + 1, "more than one transaction per frame" );
+
+	led.end();
+	pwm.end();
+	return ok;
+}
+
+// a failed transfer is repeated by the frame task without a further change.
+static bool pca9685_bus_error()
+{
+	GLedMockPCA9685 mock( PCA9685_ADDRESS );
+	GLedPCA9685 pwm( PCA9685_ADDRESS, GLedMockPCA9685::bus_write, &mock );
+	GLed led( pwm, CHANNEL );
+	bool ok = true;
+
+	pwm.begin();
+	led.begin();
+	GLedSim::run_for( 10000 );
+
+	mock.fail( 2 );
+	led.set_brightness( 128 );
+	GLedSim::run_for( 3 * GLED_PCA9685_RETRY_MS * 1000 );
+	ok &= check( pwm.get_errors() == 2, "not 2 bus errors" );
+	ok &= check( mock.get_duty( CHANNEL ) == 2056, "duty not set after the bus errors" );
+
+	led.end();
+	pwm.end();
+	return ok;
+}
+
+static const scenario_t scenarios[] = {
+	{ "expander_async_flash", expander_async_flash },
+	{ "expander_bus_error", expander_bus_error },
+	{ "expander_flush", expander_flush },
+	{ "pca9685_brightness", pca9685_brightness },
+	{ "pca9685_breathe", pca9685_breathe },
+	{ "pca9685_bus_error", pca9685_bus_error },
+};
+
+int main()
+{
+	unsigned failed = 0;
+
+	for( const scenario_t & s : scenarios ) {
+		printf( "%-24s", s.name );
+		fflush( stdout );
+		if( s.run() )
+			printf( " ok\n" );
+		else {
+			printf( "\n%-24s FAILED\n", "" );
+			failed++;
+		}
+	}
+	return failed > 0 ? 1 : 0;
+}
+
+// eof
@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       golden waveform regression of flash() and task_flash on the host.
+// premises:	   host compiler, see extras/host/sim/GLedSim.h.
+// remarks:        build and run from the root of the library:
+//                 g++ -std=gnu++17 -Iextras/host/sim -Isrc -o gled_golden extras/host/golden/GLedGoldenRun.cpp
+//                     src/GLed.cpp src/GLedPattern.cpp src/GLedGpio.cpp extras/host/sim/GLedSim.cpp -lpthread
+//                 ./gled_golden                 compare with extras/host/golden/*.txt, exit code 1 on a mismatch.
+//                 ./gled_golden --record        write the golden files after an intended change of the timing.
+//                 ./gled_golden --tolerance 0   compare the times exactly, the default is one tick.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGoldenRun.cpp
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <string>
+
+#include "GLed.h"
+#include "GLedGolden.h"
+#include "GLedSim.h"
+
+static const int PIN = 4;
+static const int OTHER_PIN = 5;
+
+typedef struct {
+	const char * name;     // golden file name without .txt
+	const char * title;
+	void (*run)();
+} scenario_t;
+
+static void flash_20()
+{
+	GLed led( PIN );
+
+	led.begin();
+	led.flash( 20 );
+	led.end();
+}
+
+static void flash_10_1000_2000()
+{
+	GLed led( PIN );
+
+	led.begin();
+	led.flash( 10, 1000, 2000 );
+	led.end();
+}
+
+static void async_flash_time_regime()
+{
+	GLed led( PIN );
+
+	led.begin();
+	led.async_flash( GLed::FLASH_FOR_EVER, 100, 400 );
+	GLedSim::run_for( 1250000 );
+	led.async_flash_set_time_regime( 50, 150 );   // in the off time of the third flash.
+	GLedSim::run_for( 1000000 );
+	led.end();
+}
+
+static void end_during_flash()
+{
+	GLed led( PIN );
+
+	led.begin();
+	led.async_flash( 10, 200, 300 );
+	GLedSim::run_for( 1100000 );                  // in the on time of the third flash.
+	led.end();
+	GLedSim::run_for( 1000000 );                  // no edge after end().
+}
+
+static void reconnect_to_pin()
+{
+	GLed led( PIN );
+
+	led.begin();
+	led.async_flash( GLed::FLASH_FOR_EVER, 100, 100 );
+	GLedSim::run_for( 650000 );                   // in the on time of the fourth flash.
+	led.reconnect_to_pin( OTHER_PIN );
+	led.begin();
+	led.async_flash( 3, 50, 50 );
+	GLedSim::run_for( 500000 );
+	led.end();
+}
+
+static const scenario_t scenarios[] = {
+	{ "flash_20", "flash( 20 )", flash_20 },
+	{ "flash_10_1000_2000", "flash( 10, 1000, 2000 )", flash_10_1000_2000 },
+	{ "async_flash_time_regime", "async_flash( FLASH_FOR_EVER, 100, 400 ), async_flash_set_time_regime( 50, 150 ) at 1250 ms", async_flash_time_regime },
+	{ "end_during_flash", "async_flash( 10, 200, 300 ), end() at 1100 ms", end_during_flash },
+	{ "reconnect_to_pin", "async_flash( FLASH_FOR_EVER, 100, 100 ) on gpio4, reconnect_to_pin( 5 ) at 650 ms, async_flash( 3, 50, 50 )", reconnect_to_pin },
+};
+
+int main( int argc, char *argv[] )
+{
+	bool record = false;
+	uint64_t tolerance = 1000 * portTICK_PERIOD_MS;
+	std::string dir = "extras/host/golden";
+	unsigned failed = 0;
+
+	for( int i = 1; i < argc; i++ ) {
+		const std::string arg = argv[i];
+		if( arg == "--record" )
+			record = true;
+		else if( arg == "--tolerance" && i + 1 < argc )
+			tolerance = strtoull( argv[++i], nullptr, 10 );
+		else if( arg[0] != '-' )
+			dir = arg;
+		else {
+			fprintf( stderr, "usage: %s [--record] [--tolerance us] [directory]\n", argv[0] );
+			return 2;
+		}
+	}
+
+	for( const scenario_t & s : scenarios ) {
+		const std::string path = dir + "/" + s.name + ".txt";
+
+		// each scenario starts on a tick and ends after the flash task has terminated:
+		GLedSim::run_until( (GLedSim::now_us() / 1000 + 1) * 1000 );
+		const uint64_t start = GLedSim::now_us();
+		GLedSim::clear_edges();
+		s.run();
+		GLedSim::run_for( 10000 );
+		const std::vector<GLedSim::edge_t> edges = GLedGolden::relative( GLedSim::get_edges(), start );
+
+		if( record ) {
+			if( ! GLedGolden::save( path.c_str(), edges, s.title ) ) {
+				fprintf( stderr, "%s: can not be written\n", path.c_str() );
+				return 2;
+			}
+			printf( "%-24s %zu edges recorded\n", s.name, edges.size() );
+			continue;
+		}
+
+		std::vector<GLedSim::edge_t> golden;
+		if( ! GLedGolden::load( path.c_str(), golden ) ) {
+			fprintf( stderr, "%s: can not be read\n", path.c_str() );
+			return 2;
+		}
+		printf( "%-24s ", s.name );
+		fflush( stdout );
+		if( GLedGolden::compare( golden, edges, tolerance, stdout ) )
+			printf( "ok\n" );
+		else {
+			printf( "%-24s FAILED\n", "" );
+			failed++;
+		}
+	}
+	return failed > 0 ? 1 : 0;
+}
+
+// eof
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       Arduino, FreeRTOS and ESP-IDF subset for host simulation.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:        only the functions used by the GLed sources are provided.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           Arduino.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_ARDUINO_HEADER_H
+#define GLED_SIM_ARDUINO_HEADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define GLED_HOST_SIM 1
+
+// ---------------------------------------------------------------------------
+// ESP-IDF basics
+
+#define ESP_IDF_VERSION_VAL( major, minor, patch ) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL( 5, 1, 0 )
+
+typedef int esp_err_t;
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_INVALID_SIZE    0x104
+#define ESP_ERR_NOT_FOUND       0x105
+#define ESP_ERR_NOT_SUPPORTED   0x106
+#define ESP_ERR_TIMEOUT         0x107
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+
+typedef enum { ESP_LOG_NONE, ESP_LOG_ERROR, ESP_LOG_WARN, ESP_LOG_INFO, ESP_LOG_DEBUG, ESP_LOG_VERBOSE } esp_log_level_t;
+
+/// print a log line with the virtual time, if the level is enabled by GLedSim::set_log_level().
+void gled_sim_log( esp_log_level_t level, const char *tag, const char *format, ... ) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE( tag, format, ... ) gled_sim_log( ESP_LOG_ERROR, tag, format, ##__VA_ARGS__ )
+#define ESP_LOGW( tag, format, ... ) gled_sim_log( ESP_LOG_WARN, tag, format, ##__VA_ARGS__ )
+#define ESP_LOGI( tag, format, ... ) gled_sim_log( ESP_LOG_INFO, tag, format, ##__VA_ARGS__ )
+#define ESP_LOGD( tag, format, ... ) gled_sim_log( ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__ )
+#define ESP_LOGV( tag, format, ... ) gled_sim_log( ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__ )
+#define ESP_EARLY_LOGW ESP_LOGW
+
+// ---------------------------------------------------------------------------
+// FreeRTOS: the tasks run one at a time on the virtual clock, see GLedSim.
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void * TaskHandle_t;
+typedef void * QueueHandle_t;
+typedef void (*TaskFunction_t)( void * );
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdPASS                  1
+#define pdFAIL                  0
+#define errQUEUE_FULL           0
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY           ((TickType_t) 0xffffffff)
+#define pdMS_TO_TICKS( ms )     ((TickType_t) (ms) / portTICK_PERIOD_MS)
+#define tskNO_AFFINITY          0x7fffffff
+#define portNUM_PROCESSORS      2
+
+BaseType_t xTaskCreatePinnedToCore( TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                                    UBaseType_t priority, TaskHandle_t *handle, BaseType_t core );
+void vTaskDelete( TaskHandle_t task );
+void vTaskDelay( TickType_t ticks );
+void taskYIELD();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t xTaskGetTickCount();
+TickType_t xTaskGetTickCountFromISR();
+
+uint32_t ulTaskNotifyTake( BaseType_t clear_on_exit, TickType_t ticks );
+void xTaskNotifyGive( TaskHandle_t task );
+void vTaskNotifyGiveFromISR( TaskHandle_t task, BaseType_t *task_woken );
+
+QueueHandle_t xQueueCreate( UBaseType_t length, UBaseType_t item_size );
+BaseType_t xQueueSend( QueueHandle_t queue, const void *item, TickType_t ticks );
+BaseType_t xQueueSendFromISR( QueueHandle_t queue, const void *item, BaseType_t *task_woken );
+BaseType_t xQueueReceive( QueueHandle_t queue, void *item, TickType_t ticks );
+
+BaseType_t xPortGetCoreID();
+BaseType_t xPortInIsrContext();
+#define portYIELD_FROM_ISR( ... )       do {} while(0)
+#define portDISABLE_INTERRUPTS()        do {} while(0)
+#define portENABLE_INTERRUPTS()         do {} while(0)
+
+// ---------------------------------------------------------------------------
+// Arduino
+
+#define LOW             0
+#define HIGH            1
+#define INPUT           0x01
+#define OUTPUT          0x03
+
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t level );
+int digitalRead( uint8_t pin );
+void delay( uint32_t ms );
+unsigned long millis();
+unsigned long micros();
+
+#endif
+
+// eof
@@ -0,0 +1,163 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       edge timelines of the host simulation compared with golden files.
+// premises:	   host compiler, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGolden.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_GOLDEN_HEADER_H
+#define GLED_GOLDEN_HEADER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "GLedSim.h"
+
+/**
+ * The GLedGolden keeps an edge timeline of a GLedSim run as a golden file
+ * and compares later runs against it.
+ * The file is plain text, one edge per line: time (us), gpio number and level,
+ * lines starting with '#' are comments. The times are relative to the start of a scenario,
+ * see relative().
+ * \n
+ * Two timelines match if they have the same edges in the same order, each at most
+ * a tolerance away from its golden time. The tolerance covers changes of the tick alignment
+ * which do not change the waveform, an edge more or less is always a mismatch.
+ * \n
+ * Example:
+ * \code
+ * const uint64_t start = GLedSim::now_us();
+ * led.flash( 3 );
+ * std::vector<GLedSim::edge_t> edges = GLedGolden::relative( GLedSim::get_edges(), start );
+ * std::vector<GLedSim::edge_t> golden;
+ * if( ! GLedGolden::load( "flash_3.txt", golden ) || ! GLedGolden::compare( golden, edges, 1000 ) )
+ *     return 1;
+ * \endcode
+ */
+class GLedGolden {
+public:
+    /**
+     * get the edges recorded since a start time, with the times relative to it.
+     * @param edges: edges of the GLedSim.
+     * @param start_us: virtual time of the start (us).
+     */
+    static std::vector<GLedSim::edge_t> relative( const std::vector<GLedSim::edge_t> & edges, uint64_t start_us )
+    {
+        std::vector<GLedSim::edge_t> result;
+
+        for( const GLedSim::edge_t & e : edges ) {
+            if( e.time_us < start_us )
+                continue;
+            GLedSim::edge_t r = e;
+            r.time_us -= start_us;
+            result.push_back( r );
+        }
+        return result;
+    }
+
+    /**
+     * write a timeline to a golden file.
+     * @param path: file name.
+     * @param edges: timeline.
+     * @param title: comment in the first line, may be nullptr.
+     * @return false if the file can not be written.
+     */
+    static bool save( const char *path, const std::vector<GLedSim::edge_t> & edges, const char *title = nullptr )
+    {
+        FILE * file = fopen( path, "w" );
+
+        if( file == nullptr )
+            return false;
+        if( title != nullptr )
+            fprintf( file, "# %s\n", title );
+        fprintf( file, "# time_us pin level\n" );
+        for( const GLedSim::edge_t & e : edges )
+            fprintf( file, "%" PRIu64 " %u %d\n", e.time_us, (unsigned) e.pin, (int) e.level );
+        return fclose( file ) == 0;
+    }
+
+    /**
+     * read a timeline from a golden file.
+     * @param path: file name.
+     * @param edges: timeline read.
+     * @return false if the file can not be read or has a malformed line.
+     */
+    static bool load( const char *path, std::vector<GLedSim::edge_t> & edges )
+    {
+        FILE * file = fopen( path, "r" );
+        char line[128];
+        bool ok = true;
+
+        edges.clear();
+        if( file == nullptr )
+            return false;
+        while( ok && fgets( line, sizeof(line), file ) != nullptr ) {
+            uint64_t time;
+            unsigned pin;
+            int level;
+
+            if( line[0] == '#' || line[0] == '\n' )
+                continue;
+            if( sscanf( line, "%" SCNu64 " %u %d", &time, &pin, &level ) == 3 ) {
+                const GLedSim::edge_t e = { time, (uint8_t) pin, level != 0 };
+                edges.push_back( e );
+            }
+            else
+                ok = false;
+        }
+        fclose( file );
+        return ok;
+    }
+
+    /**
+     * compare a timeline with the golden one.
+     * @param golden: expected edges.
+     * @param edges: edges of the run.
+     * @param tolerance_us: largest difference of the time of an edge (us).
+     * @param report: stream for the first difference, nullptr for none.
+     * @return true if the timelines match.
+     */
+    static bool compare( const std::vector<GLedSim::edge_t> & golden, const std::vector<GLedSim::edge_t> & edges,
+                         uint64_t tolerance_us, FILE *report = stderr )
+    {
+        const size_t n = golden.size() < edges.size() ? golden.size() : edges.size();
+
+        for( size_t i = 0; i < n; i++ ) {
+            const GLedSim::edge_t & g = golden[i];
+            const GLedSim::edge_t & e = edges[i];
+            const uint64_t dt = g.time_us > e.time_us ? g.time_us - e.time_us : e.time_us - g.time_us;
+
+            if( g.pin != e.pin || g.level != e.level || dt > tolerance_us ) {
+                if( report != nullptr )
+                    fprintf( report, "edge %zu: expected gpio%u=%d at %" PRIu64 " us, got gpio%u=%d at %" PRIu64 " us\n",
+                             i, (unsigned) g.pin, (int) g.level, g.time_us, (unsigned) e.pin, (int) e.level, e.time_us );
+                return false;
+            }
+        }
+        if( golden.size() != edges.size() ) {
+            if( report != nullptr )
+                fprintf( report, "expected %zu edges, got %zu\n", golden.size(), edges.size() );
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
+
+// eof
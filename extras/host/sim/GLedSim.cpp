@@ -0,0 +1,1294 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       deterministic discrete event simulation of the GLed sources on the host.
+// premises:	   host compiler with std::thread, no hardware.
+// remarks:        the FreeRTOS, esp_timer, gpio and Arduino functions of the shim headers.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedSim.cpp
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <driver/i2c.h>
+#include <driver/ledc.h>
+#include <driver/rtc_io.h>
+#include <esp32/ulp.h>
+#include <esp_timer.h>
+#include <freertos/event_groups.h>
+#include <freertos/timers.h>
+#include <soc/soc.h>
+#include <soc/soc_caps.h>
+#include <soc/gpio_reg.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+
+#include "GLedSim.h"
+
+namespace {
+
+const uint64_t NO_DEADLINE = UINT64_MAX;
+const uint64_t TICK_US = 1000 * portTICK_PERIOD_MS;
+const unsigned ULP_PERIODS = 5;
+const unsigned ULP_STEPS = 1000;                 // instructions of a run, more is taken as an endless loop.
+const unsigned RTC_SLOW_MEM_WORDS = 2048;
+
+enum task_state_t { TASK_READY, TASK_RUNNING, TASK_BLOCKED, TASK_DELETED };
+enum context_t { CONTEXT_TASK, CONTEXT_TIMER, CONTEXT_ISR };
+
+typedef struct sim_task_s {
+	const char * name;
+	TaskFunction_t function;
+	void * arg;
+	UBaseType_t priority;
+	BaseType_t core;
+	task_state_t state;
+	uint64_t ready_seq;              // FIFO order among the ready tasks of a priority.
+	std::function<bool()> wake;      // condition of a blocked task, it may take what it waits for.
+	uint64_t deadline;               // timeout of a blocked task.
+	bool timed_out;
+	uint32_t notify;                 // task notification value.
+	std::condition_variable cv;      // signalled when the task gets the baton.
+} sim_task_t;
+
+typedef struct {
+	esp_timer_cb_t callback;
+	void * arg;
+	bool isr;
+	bool armed;
+	uint64_t expiry;
+	uint64_t period;                 // 0 for a one shot timer.
+	uint64_t seq;                    // order of timers and events with equal times.
+} sim_timer_t;
+
+typedef struct {
+	uint64_t time;
+	uint64_t seq;
+	GLedSim::event_fn_t fn;
+	void * arg;
+	context_t context;               // an interrupt, or a function pended to the timer task.
+} sim_event_t;
+
+typedef struct {
+	PendedFunction_t function;
+	void * param1;
+	uint32_t param2;
+} sim_pended_t;
+
+typedef struct {
+	size_t item_size;
+	size_t length;
+	std::deque<std::vector<uint8_t>> items;
+} sim_queue_t;
+
+typedef struct {
+	EventBits_t bits;
+} sim_event_group_t;
+
+// In the deterministic mode the state is touched only by the thread holding the baton (running),
+// the mutex guards the hand over only. In the threaded mode the mutex guards the state.
+// It is never freed, the threads of deleted tasks may still wait.
+typedef struct {
+	std::mutex mutex;
+	bool threaded;
+	std::condition_variable changed;         // threaded: a condition of a blocked task may be met.
+	std::chrono::steady_clock::time_point epoch;
+	bool timer_thread;
+	sim_task_t * running;
+	std::vector<sim_task_t*> tasks;          // in the order of creation, main first.
+	std::vector<sim_timer_t*> timers;
+	std::vector<sim_event_t> events;
+	uint64_t now;
+	uint64_t seq;
+	uint64_t levels;                         // bit n: level of gpio n.
+	std::vector<GLedSim::edge_t> edges;
+	GLedSim::edge_listener_t listener;
+	void * listener_arg;
+	esp_log_level_t log_level;
+	std::vector<ulp_insn_t> ulp_program;     // labels resolved to the index of the instruction.
+	uint32_t ulp_period[ULP_PERIODS];        // wake up periods of the ULP timer [us].
+	unsigned ulp_select;                     // period until the next run, see I_SLEEP_CYCLE_SEL.
+	bool ulp_timer;                          // RTC_CNTL_ULP_CP_SLP_TIMER_EN.
+	uint64_t ulp_generation;                 // changed by a stop, the run scheduled before is dropped.
+} sim_t;
+
+// thrown by vTaskDelete( NULL ) to unwind the task function.
+struct sim_task_exit {};
+
+sim_t * sim = nullptr;
+thread_local sim_task_t * self = nullptr;
+thread_local context_t context = CONTEXT_TASK;
+
+} // namespace
+
+static void fatal( const char *format, ... ) __attribute__((format(printf, 1, 2), noreturn));
+static void fatal( const char *format, ... )
+{
+	va_list args;
+
+	va_start( args, format );
+	fprintf( stderr, "GLedSim: " );
+	vfprintf( stderr, format, args );
+	fprintf( stderr, "\n" );
+	va_end( args );
+	abort();
+}
+
+static sim_task_t * new_task( const char *name, UBaseType_t priority, BaseType_t core )
+{
+	sim_task_t * t = new sim_task_t();
+	t->name = name;
+	t->function = nullptr;
+	t->arg = nullptr;
+	t->priority = priority;
+	t->core = core;
+	t->state = TASK_RUNNING;
+	t->ready_seq = 0;
+	t->deadline = NO_DEADLINE;
+	t->timed_out = false;
+	t->notify = 0;
+	return t;
+}
+
+// the first caller becomes the task "main".
+static sim_t & state()
+{
+	if( sim == nullptr ) {
+		sim = new sim_t();
+		sim->threaded = false;
+		sim->epoch = std::chrono::steady_clock::now();
+		sim->timer_thread = false;
+		sim->now = 0;
+		sim->seq = 0;
+		sim->levels = 0;
+		sim->listener = nullptr;
+		sim->listener_arg = nullptr;
+		sim->log_level = ESP_LOG_ERROR;
+		for( unsigned i = 0; i < ULP_PERIODS; i++ )
+			sim->ulp_period[i] = 0;
+		sim->ulp_select = 0;
+		sim->ulp_timer = false;
+		sim->ulp_generation = 0;
+
+		sim_task_t * t = new_task( "main", 1, 1 );
+		sim->tasks.push_back( t );
+		sim->running = t;
+		self = t;
+	}
+	return *sim;
+}
+
+// holds the state in the threaded mode, the baton does it in the deterministic mode.
+class sim_guard {
+public:
+	sim_guard() : lock( state().mutex, std::defer_lock )
+	{
+		if( sim->threaded )
+			lock.lock();
+	}
+
+	std::unique_lock<std::mutex> lock;
+};
+
+// virtual time, or the time since the start in the threaded mode.
+static uint64_t clock_now()
+{
+	if( ! sim->threaded )
+		return sim->now;
+	return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - sim->epoch ).count();
+}
+
+// the calling task. In the threaded mode any other thread becomes a task at its first call.
+static sim_task_t * current()
+{
+	if( self == nullptr ) {
+		if( ! sim->threaded )
+			fatal( "called by a thread outside of the simulation" );
+		self = new_task( "thread", 1, tskNO_AFFINITY );
+		sim->tasks.push_back( self );
+	}
+	return self;
+}
+
+// threaded: let the blocked tasks and the timer thread check their conditions.
+static void signal()
+{
+	if( sim->threaded )
+		sim->changed.notify_all();
+}
+
+static void make_ready( sim_task_t * t, bool timed_out )
+{
+	t->state = TASK_READY;
+	t->wake = nullptr;
+	t->deadline = NO_DEADLINE;
+	t->timed_out = timed_out;
+	t->ready_seq = ++sim->seq;
+}
+
+// unblock the tasks whose condition is met or whose timeout has expired.
+static void wake_tasks()
+{
+	for( sim_task_t * t : sim->tasks ) {
+		if( t->state != TASK_BLOCKED )
+			continue;
+		if( t->wake && t->wake() )
+			make_ready( t, false );
+		else if( t->deadline <= sim->now )
+			make_ready( t, true );
+	}
+}
+
+static sim_task_t * best_ready()
+{
+	sim_task_t * best = nullptr;
+
+	for( sim_task_t * t : sim->tasks ) {
+		if( t->state != TASK_READY )
+			continue;
+		if( best == nullptr || t->priority > best->priority
+				|| (t->priority == best->priority && t->ready_seq < best->ready_seq) )
+			best = t;
+	}
+	return best;
+}
+
+// take the earliest timer or event due at a time, a periodic timer is reloaded.
+// Returns false if none is due.
+static bool take_due( uint64_t now, esp_timer_cb_t & fn, void * & arg, context_t & ctx )
+{
+	sim_timer_t * timer = nullptr;
+	int event = -1;
+	uint64_t time = now + 1, seq = 0;
+
+	for( sim_timer_t * tm : sim->timers ) {
+		if( tm->armed && (tm->expiry < time || (tm->expiry == time && tm->seq < seq)) ) {
+			timer = tm;
+			time = tm->expiry;
+			seq = tm->seq;
+		}
+	}
+	for( size_t i = 0; i < sim->events.size(); i++ ) {
+		const sim_event_t & e = sim->events[i];
+		if( e.time < time || (e.time == time && e.seq < seq) ) {
+			timer = nullptr;
+			event = (int) i;
+			time = e.time;
+			seq = e.seq;
+		}
+	}
+
+	if( event >= 0 ) {
+		fn = sim->events[event].fn;
+		arg = sim->events[event].arg;
+		ctx = sim->events[event].context;
+		sim->events.erase( sim->events.begin() + event );
+		return true;
+	}
+	if( timer != nullptr ) {
+		if( timer->period > 0 ) {
+			timer->expiry += timer->period;
+			timer->seq = ++sim->seq;
+		}
+		else
+			timer->armed = false;
+		fn = timer->callback;
+		arg = timer->arg;
+		ctx = timer->isr ? CONTEXT_ISR : CONTEXT_TIMER;
+		return true;
+	}
+	return false;
+}
+
+// earliest time a task, a timer or an event waits for.
+static uint64_t next_time()
+{
+	uint64_t time = NO_DEADLINE;
+
+	for( sim_task_t * t : sim->tasks )
+		if( t->state == TASK_BLOCKED && t->deadline < time )
+			time = t->deadline;
+	for( sim_timer_t * tm : sim->timers )
+		if( tm->armed && tm->expiry < time )
+			time = tm->expiry;
+	for( const sim_event_t & e : sim->events )
+		if( e.time < time )
+			time = e.time;
+	return time;
+}
+
+// threaded: fire the timers and the events at their time, like the esp_timer task and the interrupts.
+static void timer_main()
+{
+	std::unique_lock<std::mutex> lock( sim->mutex );
+
+	for(;;) {
+		esp_timer_cb_t fn;
+		void * arg;
+		context_t ctx;
+
+		const uint64_t now = clock_now();
+		if( take_due( now, fn, arg, ctx ) ) {
+			lock.unlock();
+			context = ctx;
+			fn( arg );
+			context = CONTEXT_TASK;
+			lock.lock();
+			continue;
+		}
+
+		// the tasks are woken by their own timeouts, only the timers and events count here:
+		uint64_t time = NO_DEADLINE;
+		for( sim_timer_t * tm : sim->timers )
+			if( tm->armed && tm->expiry < time )
+				time = tm->expiry;
+		for( const sim_event_t & e : sim->events )
+			if( e.time < time )
+				time = e.time;
+		if( time == NO_DEADLINE )
+			sim->changed.wait( lock );
+		else
+			sim->changed.wait_for( lock, std::chrono::microseconds( time - now ) );
+	}
+}
+
+static void start_timer_thread()
+{
+	if( sim->threaded && ! sim->timer_thread ) {
+		sim->timer_thread = true;
+		std::thread( timer_main ).detach();
+	}
+}
+
+// pass the baton to a task and wait until it comes back, unless the caller ends.
+static void switch_to( sim_task_t * next, sim_task_t * me, bool exiting )
+{
+	std::unique_lock<std::mutex> lock( sim->mutex );
+
+	sim->running = next;
+	next->state = TASK_RUNNING;
+	if( next == me )
+		return;
+	next->cv.notify_one();
+	if( exiting )
+		return;
+	me->cv.wait( lock, [me]{ return sim->running == me; } );
+}
+
+// run the other tasks, the timers and the events until the caller is the ready task of the highest priority.
+static void schedule( sim_task_t * me, bool exiting )
+{
+	for(;;) {
+		wake_tasks();
+		sim_task_t * next = best_ready();
+		if( next != nullptr ) {
+			switch_to( next, me, exiting );
+			return;
+		}
+
+		esp_timer_cb_t fn;
+		void * arg;
+		context_t ctx;
+		if( take_due( sim->now, fn, arg, ctx ) ) {
+			context = ctx;
+			fn( arg );
+			context = CONTEXT_TASK;
+			continue;
+		}
+
+		const uint64_t time = next_time();
+		if( time == NO_DEADLINE ) {
+			fprintf( stderr, "GLedSim: deadlock at %" PRIu64 " us, the tasks wait for ever:\n", sim->now );
+			for( sim_task_t * t : sim->tasks )
+				if( t->state == TASK_BLOCKED )
+					fprintf( stderr, "  %s\n", t->name );
+			abort();
+		}
+		sim->now = time;
+	}
+}
+
+// block the calling task until the condition is met or the deadline has passed.
+// Returns true on timeout.
+static bool block( sim_guard & guard, std::function<bool()> wake, uint64_t deadline )
+{
+	if( context != CONTEXT_TASK )
+		fatal( "a blocking call outside of a task" );
+	sim_task_t * me = current();
+
+	if( sim->threaded ) {
+		for(;;) {
+			if( wake && wake() )
+				return false;
+			const uint64_t now = clock_now();
+			if( now >= deadline )
+				return true;
+			if( deadline == NO_DEADLINE )
+				sim->changed.wait( guard.lock );
+			else
+				sim->changed.wait_for( guard.lock, std::chrono::microseconds( deadline - now ) );
+		}
+	}
+
+	me->state = TASK_BLOCKED;
+	me->wake = wake;
+	me->deadline = deadline;
+	schedule( me, false );
+	return me->timed_out;
+}
+
+// deterministic: a task of a higher priority made ready by the caller runs at once.
+static void preempt()
+{
+	if( sim->threaded || context != CONTEXT_TASK )
+		return;
+
+	sim_task_t * me = current();
+	wake_tasks();
+	const sim_task_t * next = best_ready();
+	if( next != nullptr && next->priority > me->priority ) {
+		make_ready( me, false );
+		schedule( me, false );
+	}
+}
+
+static void yield()
+{
+	if( sim->threaded ) {
+		std::this_thread::yield();
+		return;
+	}
+
+	sim_task_t * me = current();
+	make_ready( me, false );
+	schedule( me, false );
+}
+
+// a task woken in an ISR which has a higher priority than the interrupted one.
+static BaseType_t woken( const sim_task_t * t )
+{
+	return t != nullptr && t->priority > sim->running->priority ? pdTRUE : pdFALSE;
+}
+
+static uint64_t tick_deadline( TickType_t ticks )
+{
+	if( ticks == portMAX_DELAY )
+		return NO_DEADLINE;
+	return (clock_now() / TICK_US + ticks) * TICK_US;
+}
+
+static void task_main( sim_task_t * t )
+{
+	self = t;
+	if( ! sim->threaded ) {
+		std::unique_lock<std::mutex> lock( sim->mutex );
+		t->cv.wait( lock, [t]{ return sim->running == t; } );
+	}
+	try {
+		t->function( t->arg );
+		fatal( "task %s returned without vTaskDelete()", t->name );
+	}
+	catch( const sim_task_exit & ) {
+	}
+
+	sim_guard guard;
+	t->state = TASK_DELETED;
+	if( ! sim->threaded )
+		schedule( t, true );
+}
+
+static void set_level( int pin, bool level )
+{
+	const uint64_t bit = 1ull << pin;
+
+	if( ((sim->levels & bit) != 0) == level )
+		return;
+	sim->levels ^= bit;
+
+	const GLedSim::edge_t edge = { clock_now(), (uint8_t) pin, level };
+	sim->edges.push_back( edge );
+	if( sim->listener != nullptr )
+		sim->listener( edge, sim->listener_arg );
+}
+
+static void write_bank( int bank, uint32_t value )
+{
+	const uint32_t old = (uint32_t) (sim->levels >> (32 * bank));
+	uint32_t changed = old ^ value;
+
+	if( bank > 0 )
+		changed &= (1u << (SOC_GPIO_PIN_COUNT - 32)) - 1;
+	while( changed ) {
+		const int n = __builtin_ctz( changed );
+		changed &= changed - 1;
+		set_level( 32 * bank + n, (value >> n) & 1 );
+	}
+}
+
+static void schedule_ulp( uint64_t time );
+
+static void set_ulp_timer( bool enabled )
+{
+	if( ! enabled )
+		sim->ulp_generation++;
+	sim->ulp_timer = enabled;
+}
+
+// ---------------------------------------------------------------------------
+// test interface
+
+void GLedSim::set_threaded( bool threaded )
+{
+	sim_t & s = state();
+
+	if( s.tasks.size() > 1 || ! s.timers.empty() || ! s.events.empty() || s.now > 0 )
+		fatal( "set_threaded() has to be called before anything else" );
+	s.threaded = threaded;
+	s.epoch = std::chrono::steady_clock::now();
+}
+
+bool GLedSim::is_threaded()
+{
+	return state().threaded;
+}
+
+uint64_t GLedSim::now_us()
+{
+	sim_guard guard;
+	return clock_now();
+}
+
+void GLedSim::run_for( uint64_t us )
+{
+	sim_guard guard;
+	block( guard, nullptr, clock_now() + us );
+}
+
+void GLedSim::run_until( uint64_t time_us )
+{
+	sim_guard guard;
+	if( time_us > clock_now() )
+		block( guard, nullptr, time_us );
+}
+
+void GLedSim::at( uint64_t time_us, event_fn_t fn, void *arg )
+{
+	sim_guard guard;
+	const uint64_t now = clock_now();
+	const sim_event_t e = { time_us > now ? time_us : now, ++sim->seq, fn, arg, CONTEXT_ISR };
+
+	sim->events.push_back( e );
+	start_timer_thread();
+	signal();
+}
+
+const std::vector<GLedSim::edge_t> & GLedSim::get_edges()
+{
+	return state().edges;
+}
+
+void GLedSim::clear_edges()
+{
+	sim_guard guard;
+	sim->edges.clear();
+}
+
+bool GLedSim::get_level( int pin )
+{
+	sim_guard guard;
+	return (sim->levels >> pin) & 1;
+}
+
+void GLedSim::set_edge_listener( edge_listener_t listener, void *arg )
+{
+	sim_guard guard;
+	sim->listener = listener;
+	sim->listener_arg = arg;
+}
+
+void GLedSim::set_log_level( esp_log_level_t level )
+{
+	sim_guard guard;
+	sim->log_level = level;
+}
+
+unsigned GLedSim::get_tasks()
+{
+	sim_guard guard;
+	unsigned n = 0;
+
+	for( const sim_task_t * t : sim->tasks )
+		if( t->state != TASK_DELETED && t->function != nullptr )
+			n++;
+	return n;
+}
+
+void gled_sim_log( esp_log_level_t level, const char *tag, const char *format, ... )
+{
+	sim_guard guard;
+	va_list args;
+
+	if( level == ESP_LOG_NONE || level > sim->log_level )
+		return;
+
+	const uint64_t now = clock_now();
+	const char * name = context == CONTEXT_ISR ? "isr" : context == CONTEXT_TIMER ? "esp_timer"
+			: self != nullptr ? self->name : "thread";
+	printf( "%c (%" PRIu64 ".%03u ms, %s) %s: ", "NEWIDV"[level], now / 1000, (unsigned) (now % 1000), name, tag );
+	va_start( args, format );
+	vprintf( format, args );
+	va_end( args );
+	printf( "\n" );
+}
+
+// ---------------------------------------------------------------------------
+// FreeRTOS
+
+BaseType_t xTaskCreatePinnedToCore( TaskFunction_t function, const char *name, uint32_t, void *arg,
+                                    UBaseType_t priority, TaskHandle_t *handle, BaseType_t core )
+{
+	sim_guard guard;
+
+	current();
+	sim_task_t * t = new_task( name, priority, core );
+	t->function = function;
+	t->arg = arg;
+	make_ready( t, false );
+	if( sim->threaded )
+		t->state = TASK_RUNNING;
+	sim->tasks.push_back( t );
+	if( handle != nullptr )
+		*handle = t;
+
+	std::thread( task_main, t ).detach();
+	preempt();
+	return pdPASS;
+}
+
+void vTaskDelete( TaskHandle_t task )
+{
+	sim_guard guard;
+	sim_task_t * me = current();
+	sim_task_t * t = (sim_task_t*) task;
+
+	if( t == nullptr || t == me )
+		throw sim_task_exit();
+	// the thread of the task keeps waiting for the baton for ever, or runs on in the threaded mode.
+	t->state = TASK_DELETED;
+}
+
+void vTaskDelay( TickType_t ticks )
+{
+	sim_guard guard;
+
+	if( ticks == 0 )
+		yield();
+	else
+		block( guard, nullptr, tick_deadline( ticks ) );
+}
+
+void taskYIELD()
+{
+	sim_guard guard;
+
+	if( sim->threaded )
+		guard.lock.unlock();
+	yield();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	sim_guard guard;
+	return context == CONTEXT_TASK ? current() : nullptr;
+}
+
+TickType_t xTaskGetTickCount()
+{
+	sim_guard guard;
+	return (TickType_t) (clock_now() / TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR()
+{
+	return xTaskGetTickCount();
+}
+
+uint32_t ulTaskNotifyTake( BaseType_t clear_on_exit, TickType_t ticks )
+{
+	sim_guard guard;
+	sim_task_t * me = current();
+
+	if( me->notify == 0 && ticks > 0 )
+		block( guard, [me]{ return me->notify > 0; }, tick_deadline( ticks ) );
+
+	const uint32_t value = me->notify;
+	if( value > 0 )
+		me->notify = clear_on_exit ? 0 : value - 1;
+	return value;
+}
+
+void xTaskNotifyGive( TaskHandle_t task )
+{
+	sim_guard guard;
+
+	((sim_task_t*) task)->notify++;
+	signal();
+	preempt();
+}
+
+void vTaskNotifyGiveFromISR( TaskHandle_t task, BaseType_t *task_woken )
+{
+	sim_guard guard;
+
+	((sim_task_t*) task)->notify++;
+	signal();
+	if( task_woken != nullptr && woken( (sim_task_t*) task ) )
+		*task_woken = pdTRUE;
+}
+
+QueueHandle_t xQueueCreate( UBaseType_t length, UBaseType_t item_size )
+{
+	sim_guard guard;
+	sim_queue_t * q = new sim_queue_t();
+
+	q->item_size = item_size;
+	q->length = length;
+	return q;
+}
+
+static bool queue_put( sim_queue_t * q, const void *item )
+{
+	if( q->items.size() >= q->length )
+		return false;
+	const uint8_t * p = (const uint8_t*) item;
+	q->items.emplace_back( p, p + q->item_size );
+	signal();
+	return true;
+}
+
+static bool queue_take( sim_queue_t * q, void *item )
+{
+	if( q->items.empty() )
+		return false;
+	memcpy( item, q->items.front().data(), q->item_size );
+	q->items.pop_front();
+	signal();
+	return true;
+}
+
+BaseType_t xQueueSend( QueueHandle_t queue, const void *item, TickType_t ticks )
+{
+	sim_guard guard;
+	sim_queue_t * q = (sim_queue_t*) queue;
+
+	current();
+	if( ! queue_put( q, item ) ) {
+		if( ticks == 0 || block( guard, [q, item]{ return queue_put( q, item ); }, tick_deadline( ticks ) ) )
+			return errQUEUE_FULL;
+	}
+	preempt();
+	return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR( QueueHandle_t queue, const void *item, BaseType_t *task_woken )
+{
+	sim_guard guard;
+	sim_queue_t * q = (sim_queue_t*) queue;
+
+	if( ! queue_put( q, item ) )
+		return errQUEUE_FULL;
+	if( task_woken != nullptr ) {
+		// a receiver of a higher priority waiting for the item.
+		for( const sim_task_t * t : sim->tasks )
+			if( t->state == TASK_BLOCKED && t->wake && woken( t ) )
+				*task_woken = pdTRUE;
+	}
+	return pdPASS;
+}
+
+BaseType_t xQueueReceive( QueueHandle_t queue, void *item, TickType_t ticks )
+{
+	sim_guard guard;
+	sim_queue_t * q = (sim_queue_t*) queue;
+
+	current();
+	if( ! queue_take( q, item ) ) {
+		if( ticks == 0 || block( guard, [q, item]{ return queue_take( q, item ); }, tick_deadline( ticks ) ) )
+			return pdFALSE;
+	}
+	preempt();
+	return pdTRUE;
+}
+
+EventGroupHandle_t xEventGroupCreate()
+{
+	sim_guard guard;
+	sim_event_group_t * g = new sim_event_group_t();
+
+	g->bits = 0;
+	return g;
+}
+
+EventBits_t xEventGroupSetBits( EventGroupHandle_t group, EventBits_t bits )
+{
+	sim_guard guard;
+	sim_event_group_t * g = (sim_event_group_t*) group;
+
+	g->bits |= bits;
+	const EventBits_t value = g->bits;
+	signal();
+	preempt();
+	return value;
+}
+
+EventBits_t xEventGroupClearBits( EventGroupHandle_t group, EventBits_t bits )
+{
+	sim_guard guard;
+	sim_event_group_t * g = (sim_event_group_t*) group;
+
+	const EventBits_t value = g->bits;
+	g->bits &= ~bits;
+	return value;
+}
+
+EventBits_t xEventGroupGetBits( EventGroupHandle_t group )
+{
+	sim_guard guard;
+	return ((sim_event_group_t*) group)->bits;
+}
+
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                 BaseType_t wait_for_all, TickType_t ticks )
+{
+	sim_guard guard;
+	sim_event_group_t * g = (sim_event_group_t*) group;
+	EventBits_t value = 0;
+
+	// the bits are taken when the condition is met, like FreeRTOS does in xEventGroupSetBits().
+	auto take = [g, bits, clear_on_exit, wait_for_all, &value]{
+		value = g->bits;
+		if( wait_for_all ? (value & bits) != bits : (value & bits) == 0 )
+			return false;
+		if( clear_on_exit )
+			g->bits &= ~bits;
+		return true;
+	};
+
+	current();
+	if( ! take() && ticks > 0 && block( guard, take, tick_deadline( ticks ) ) )
+		value = g->bits;
+	return value;
+}
+
+// a pended function runs like an esp_timer callback: when all tasks wait, or at once in the threaded mode.
+static void run_pended( void *arg )
+{
+	sim_pended_t * p = (sim_pended_t*) arg;
+
+	p->function( p->param1, p->param2 );
+	delete p;
+}
+
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t function, void *param1, uint32_t param2,
+                                          BaseType_t * )
+{
+	sim_guard guard;
+	const sim_event_t e = { clock_now(), ++sim->seq, run_pended, new sim_pended_t { function, param1, param2 }, CONTEXT_TIMER };
+
+	sim->events.push_back( e );
+	start_timer_thread();
+	signal();
+	return pdPASS;
+}
+
+BaseType_t xPortGetCoreID()
+{
+	sim_guard guard;
+	const sim_task_t * t = self;
+	return context == CONTEXT_TASK && t != nullptr && t->core >= 0 && t->core < portNUM_PROCESSORS ? t->core : 0;
+}
+
+BaseType_t xPortInIsrContext()
+{
+	return context == CONTEXT_ISR;
+}
+
+// ---------------------------------------------------------------------------
+// esp_timer
+
+esp_err_t esp_timer_create( const esp_timer_create_args_t *args, esp_timer_handle_t *handle )
+{
+	if( args == nullptr || args->callback == nullptr || handle == nullptr )
+		return ESP_ERR_INVALID_ARG;
+
+	sim_guard guard;
+	sim_timer_t * tm = new sim_timer_t();
+	tm->callback = args->callback;
+	tm->arg = args->arg;
+	tm->isr = args->dispatch_method == ESP_TIMER_ISR;
+	tm->armed = false;
+	tm->expiry = 0;
+	tm->period = 0;
+	tm->seq = 0;
+	sim->timers.push_back( tm );
+	*handle = tm;
+	return ESP_OK;
+}
+
+static esp_err_t timer_start( esp_timer_handle_t timer, uint64_t us, uint64_t period )
+{
+	sim_guard guard;
+	sim_timer_t * tm = (sim_timer_t*) timer;
+
+	if( tm == nullptr )
+		return ESP_ERR_INVALID_ARG;
+	if( tm->armed )
+		return ESP_ERR_INVALID_STATE;
+	tm->armed = true;
+	tm->expiry = clock_now() + us;
+	tm->period = period;
+	tm->seq = ++sim->seq;
+	start_timer_thread();
+	signal();
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once( esp_timer_handle_t timer, uint64_t timeout_us )
+{
+	return timer_start( timer, timeout_us, 0 );
+}
+
+esp_err_t esp_timer_start_periodic( esp_timer_handle_t timer, uint64_t period_us )
+{
+	if( period_us == 0 )
+		return ESP_ERR_INVALID_ARG;
+	return timer_start( timer, period_us, period_us );
+}
+
+esp_err_t esp_timer_stop( esp_timer_handle_t timer )
+{
+	sim_guard guard;
+	sim_timer_t * tm = (sim_timer_t*) timer;
+
+	if( tm == nullptr )
+		return ESP_ERR_INVALID_ARG;
+	if( ! tm->armed )
+		return ESP_ERR_INVALID_STATE;
+	tm->armed = false;
+	return ESP_OK;
+}
+
+esp_err_t esp_timer_delete( esp_timer_handle_t timer )
+{
+	sim_guard guard;
+	sim_timer_t * tm = (sim_timer_t*) timer;
+
+	if( tm == nullptr )
+		return ESP_ERR_INVALID_ARG;
+	if( tm->armed )
+		return ESP_ERR_INVALID_STATE;
+	for( size_t i = 0; i < sim->timers.size(); i++ ) {
+		if( sim->timers[i] == tm ) {
+			sim->timers.erase( sim->timers.begin() + i );
+			break;
+		}
+	}
+	delete tm;
+	return ESP_OK;
+}
+
+int64_t esp_timer_get_time()
+{
+	sim_guard guard;
+	return (int64_t) clock_now();
+}
+
+// ---------------------------------------------------------------------------
+// gpio and Arduino
+
+void gled_sim_reg_write( uint32_t reg, uint32_t value )
+{
+	sim_guard guard;
+
+	switch( reg ) {
+	case GPIO_OUT_REG:
+		write_bank( 0, value );
+		break;
+	case GPIO_OUT_W1TS_REG:
+		write_bank( 0, (uint32_t) sim->levels | value );
+		break;
+	case GPIO_OUT_W1TC_REG:
+		write_bank( 0, (uint32_t) sim->levels & ~value );
+		break;
+	case GPIO_OUT1_REG:
+		write_bank( 1, value );
+		break;
+	case GPIO_OUT1_W1TS_REG:
+		write_bank( 1, (uint32_t) (sim->levels >> 32) | value );
+		break;
+	case GPIO_OUT1_W1TC_REG:
+		write_bank( 1, (uint32_t) (sim->levels >> 32) & ~value );
+		break;
+	case RTC_CNTL_STATE0_REG:
+		if( ! (value & RTC_CNTL_ULP_CP_SLP_TIMER_EN) )
+			set_ulp_timer( false );
+		else if( ! sim->ulp_timer ) {
+			set_ulp_timer( true );
+			schedule_ulp( clock_now() + sim->ulp_period[sim->ulp_select] );
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+uint32_t gled_sim_reg_read( uint32_t reg )
+{
+	sim_guard guard;
+
+	switch( reg ) {
+	case GPIO_OUT_REG:
+		return (uint32_t) sim->levels;
+	case GPIO_OUT1_REG:
+		return (uint32_t) (sim->levels >> 32);
+	case RTC_CNTL_STATE0_REG:
+		return sim->ulp_timer ? RTC_CNTL_ULP_CP_SLP_TIMER_EN : 0;
+	default:
+		return 0;
+	}
+}
+
+void pinMode( uint8_t, uint8_t )
+{
+}
+
+void digitalWrite( uint8_t pin, uint8_t level )
+{
+	sim_guard guard;
+
+	if( pin < SOC_GPIO_PIN_COUNT )
+		set_level( pin, level != LOW );
+}
+
+int digitalRead( uint8_t pin )
+{
+	return pin < SOC_GPIO_PIN_COUNT && GLedSim::get_level( pin ) ? HIGH : LOW;
+}
+
+void delay( uint32_t ms )
+{
+	vTaskDelay( ms / portTICK_PERIOD_MS );
+}
+
+unsigned long millis()
+{
+	sim_guard guard;
+	return (unsigned long) (clock_now() / 1000);
+}
+
+unsigned long micros()
+{
+	sim_guard guard;
+	return (unsigned long) clock_now();
+}
+
+// ---------------------------------------------------------------------------
+// LEDC: accepted, but the LEDC does not drive the pin.
+
+esp_err_t ledc_timer_config( const ledc_timer_config_t * ) { return ESP_OK; }
+esp_err_t ledc_channel_config( const ledc_channel_config_t * ) { return ESP_OK; }
+esp_err_t ledc_fade_func_install( int ) { return ESP_OK; }
+esp_err_t ledc_cb_register( ledc_mode_t, ledc_channel_t, ledc_cbs_t *, void * ) { return ESP_OK; }
+esp_err_t ledc_set_fade_with_time( ledc_mode_t, ledc_channel_t, uint32_t, int ) { return ESP_OK; }
+esp_err_t ledc_fade_start( ledc_mode_t, ledc_channel_t, ledc_fade_mode_t ) { return ESP_OK; }
+esp_err_t ledc_fade_stop( ledc_mode_t, ledc_channel_t ) { return ESP_OK; }
+esp_err_t ledc_stop( ledc_mode_t, ledc_channel_t, uint32_t ) { return ESP_OK; }
+esp_err_t ledc_set_duty( ledc_mode_t, ledc_channel_t, uint32_t ) { return ESP_OK; }
+esp_err_t ledc_update_duty( ledc_mode_t, ledc_channel_t ) { return ESP_OK; }
+
+// ---------------------------------------------------------------------------
+// RTC gpio and ULP: the program runs at once at ulp_run(), then after each I_HALT when the period
+// selected by I_SLEEP_CYCLE_SEL has passed, until the ULP timer is stopped.
+
+uint32_t gled_sim_rtc_slow_mem[RTC_SLOW_MEM_WORDS];
+
+// RTC io number of the ESP32 gpios 0..39, -1 for the others.
+static const int8_t rtc_io_numbers[] = {
+	11, -1, 12, -1, 10, -1, -1, -1, -1, -1, -1, -1, 15, 14, 16, 13, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1,  6,  7, 17, -1, -1, -1, -1,  9,  8,  4,  5,  0,  1,  2,  3
+};
+
+bool rtc_gpio_is_valid_gpio( gpio_num_t gpio )
+{
+	return rtc_io_number_get( gpio ) >= 0;
+}
+
+int rtc_io_number_get( gpio_num_t gpio )
+{
+	return gpio >= 0 && gpio < (int) sizeof(rtc_io_numbers) ? rtc_io_numbers[gpio] : -1;
+}
+
+esp_err_t rtc_gpio_init( gpio_num_t gpio ) { return rtc_gpio_is_valid_gpio( gpio ) ? ESP_OK : ESP_ERR_INVALID_ARG; }
+esp_err_t rtc_gpio_deinit( gpio_num_t gpio ) { return rtc_gpio_is_valid_gpio( gpio ) ? ESP_OK : ESP_ERR_INVALID_ARG; }
+esp_err_t rtc_gpio_set_direction( gpio_num_t gpio, rtc_gpio_mode_t ) { return rtc_gpio_init( gpio ); }
+
+esp_err_t rtc_gpio_set_level( gpio_num_t gpio, uint32_t level )
+{
+	if( ! rtc_gpio_is_valid_gpio( gpio ) )
+		return ESP_ERR_INVALID_ARG;
+	sim_guard guard;
+	set_level( gpio, level != 0 );
+	return ESP_OK;
+}
+
+// RTC_GPIO_OUT_W1TS_REG and RTC_GPIO_OUT_W1TC_REG, the other registers are ignored.
+static void ulp_write_reg( uint32_t reg, unsigned low, unsigned high, uint32_t value )
+{
+	if( reg != RTC_GPIO_OUT_W1TS_REG && reg != RTC_GPIO_OUT_W1TC_REG )
+		return;
+	for( unsigned bit = low; bit <= high; bit++ ) {
+		if( ! ((value >> (bit - low)) & 1) || bit < RTC_GPIO_OUT_DATA_W1TS_S )
+			continue;
+		for( int gpio = 0; gpio < (int) sizeof(rtc_io_numbers); gpio++ )
+			if( rtc_io_numbers[gpio] == (int) (bit - RTC_GPIO_OUT_DATA_W1TS_S) )
+				set_level( gpio, reg == RTC_GPIO_OUT_W1TS_REG );
+	}
+}
+
+// one run of the program, from the entry to I_HALT.
+static void ulp_wake( void *arg )
+{
+	sim_guard guard;
+	uint32_t r[4] = { 0, 0, 0, 0 };
+	size_t pc = 0;
+
+	if( ! sim->ulp_timer || (uint64_t) (uintptr_t) arg != sim->ulp_generation )
+		return;
+	for( unsigned steps = 0; ; steps++ ) {
+		if( pc >= sim->ulp_program.size() || steps >= ULP_STEPS )
+			fatal( "ULP program runs beyond its end or for ever" );
+		const ulp_insn_t & i = sim->ulp_program[pc++];
+
+		switch( i.opcode ) {
+		case GLED_SIM_ULP_MOVI:
+			r[i.rd] = i.imm & 0xffff;
+			break;
+		case GLED_SIM_ULP_LD:
+			r[i.rd] = gled_sim_rtc_slow_mem[(r[i.rs] + i.imm) % RTC_SLOW_MEM_WORDS] & 0xffff;
+			break;
+		case GLED_SIM_ULP_ST:
+			gled_sim_rtc_slow_mem[(r[i.rs] + i.imm) % RTC_SLOW_MEM_WORDS] = r[i.rd];
+			break;
+		case GLED_SIM_ULP_SUBI:
+			r[i.rd] = (r[i.rs] - i.imm) & 0xffff;
+			break;
+		case GLED_SIM_ULP_BGE:
+			if( r[R0] >= (uint32_t) i.imm )
+				pc = i.arg;
+			break;
+		case GLED_SIM_ULP_BL:
+			if( r[R0] < (uint32_t) i.imm )
+				pc = i.arg;
+			break;
+		case GLED_SIM_ULP_WR_REG:
+			ulp_write_reg( i.arg, i.low, i.high, i.imm );
+			break;
+		case GLED_SIM_ULP_SLEEP:
+			sim->ulp_select = i.imm % ULP_PERIODS;
+			break;
+		case GLED_SIM_ULP_END:   // stops the timer, the program goes on until I_HALT.
+			set_ulp_timer( false );
+			break;
+		case GLED_SIM_ULP_HALT:
+			if( sim->ulp_timer )
+				schedule_ulp( clock_now() + sim->ulp_period[sim->ulp_select] );
+			return;
+		default:
+			fatal( "ULP instruction %u not simulated", i.opcode );
+		}
+	}
+}
+
+static void schedule_ulp( uint64_t time )
+{
+	const sim_event_t e = { time, ++sim->seq, ulp_wake, (void*) (uintptr_t) sim->ulp_generation, CONTEXT_ISR };
+
+	sim->events.push_back( e );
+	start_timer_thread();
+	signal();
+}
+
+esp_err_t ulp_process_macros_and_load( uint32_t load_addr, const ulp_insn_t *program, size_t *psize )
+{
+	sim_guard guard;
+	std::vector<ulp_insn_t> code;
+	std::vector<std::pair<uint32_t, size_t>> labels;
+
+	if( load_addr >= RTC_SLOW_MEM_WORDS )
+		return ESP_ERR_INVALID_ARG;
+	for( size_t i = 0; i < *psize; i++ ) {
+		if( program[i].opcode == GLED_SIM_ULP_LABEL )
+			labels.emplace_back( program[i].arg, code.size() );
+		else
+			code.push_back( program[i] );
+	}
+	for( ulp_insn_t & i : code ) {
+		if( i.opcode != GLED_SIM_ULP_BGE && i.opcode != GLED_SIM_ULP_BL )
+			continue;
+		size_t n = 0;
+		while( n < labels.size() && labels[n].first != i.arg )
+			n++;
+		if( n == labels.size() )
+			return ESP_ERR_NOT_FOUND;
+		i.arg = labels[n].second;
+	}
+	sim->ulp_program = code;
+	*psize = code.size();
+	return ESP_OK;
+}
+
+esp_err_t ulp_run( uint32_t )
+{
+	sim_guard guard;
+
+	set_ulp_timer( false );
+	set_ulp_timer( true );
+	schedule_ulp( clock_now() );
+	return ESP_OK;
+}
+
+esp_err_t ulp_set_wakeup_period( size_t period_index, uint32_t period_us )
+{
+	if( period_index >= ULP_PERIODS )
+		return ESP_ERR_INVALID_ARG;
+	sim_guard guard;
+	sim->ulp_period[period_index] = period_us;
+	return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// I2C: no device on the bus, a backend uses the bus write function of a mock instead.
+
+esp_err_t i2c_master_write_to_device( i2c_port_t, uint8_t, const uint8_t *, size_t, TickType_t ) { return ESP_FAIL; }
+
+// eof
@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       deterministic discrete event simulation of the GLed sources on the host.
+// premises:	   host compiler with std::thread, no hardware.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedSim.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_HEADER_H
+#define GLED_SIM_HEADER_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * The GLedSim runs the unchanged GLed sources on the host against a virtual clock.
+ * The headers of this directory take the place of the Arduino core and the ESP-IDF,
+ * so a program is built with them ahead of src/ in the include path:
+ * \code
+ * g++ -std=gnu++17 -Iextras/host/sim -Isrc -o sim my_scenario.cpp \
+ *     src/GLed.cpp src/GLedPattern.cpp src/GLedGpio.cpp extras/host/sim/GLedSim.cpp -lpthread
+ * \endcode
+ * \n
+ * Each FreeRTOS task is a thread, but only one of them runs at a time, like on a single core
+ * without time slicing: a task runs in zero virtual time until it blocks, then the ready task
+ * of the highest priority takes over, FIFO among equal priorities. A task which makes a task
+ * of a higher priority ready (create, notify, queue, event group) is preempted at once.
+ * If no task is ready, the clock jumps to the next deadline, timer or event at once,
+ * so a sequence of hours is simulated in milliseconds. Timers and events fire in the order
+ * of their time, equal times in the order they were started.
+ * Thus a run is reproducible edge by edge, independent of the load of the host.
+ * \n
+ * The program itself is the task "main" with priority 1, like the Arduino loop task.
+ * vTaskDelay() and the ticks are aligned to the 1 ms tick like on the target,
+ * esp_timer_get_time() and micros() have the resolution of 1 us.
+ * \n
+ * The gpio output registers (REG_WRITE) and digitalWrite() record an edge per level change.
+ * The ULP runs the programs of GLedUlp on the RTC gpios, built with CONFIG_IDF_TARGET_ESP32
+ * and CONFIG_ULP_COPROC_ENABLED. The LEDC, the other drivers and the power management are not simulated.
+ * \n
+ * Example, the edges of a flash sequence:
+ * \code
+ * GLed led( 4 );
+ *
+ * led.begin();
+ * led.async_flash( 3, 100, 400 );
+ * GLedSim::run_for( 2000000 );
+ * for( const GLedSim::edge_t & e : GLedSim::get_edges() )
+ *     printf( "%" PRIu64 " us: gpio%u=%d\n", e.time_us, e.pin, e.level );
+ * \endcode
+ */
+class GLedSim {
+public:
+    /// level change of a gpio pin.
+    typedef struct {
+        uint64_t time_us;   ///< virtual time of the change
+        uint8_t pin;        ///< gpio number
+        bool level;         ///< new level
+    } edge_t;
+
+    /// function called at a virtual time in interrupt context, see at().
+    typedef void (*event_fn_t)( void *arg );
+
+    /// function called for each edge when it is recorded, see set_edge_listener().
+    typedef void (*edge_listener_t)( const edge_t & edge, void *arg );
+
+    /**
+     * run the tasks concurrently as real threads on the real clock instead, for stress tests
+     * with the thread sanitizer. The state of the simulation is guarded by a mutex,
+     * a blocked task waits for real time, the timers and the events fire in a thread of their own.
+     * Any thread of the program may call the FreeRTOS functions, it becomes a task at its first call.
+     * The runs are not reproducible and there is no preemption by priority.
+     * Call it first, before any other function of the simulation.
+     * @param threaded: true for the threaded mode.
+     */
+    static void set_threaded( bool threaded );
+
+    /**
+     * check for the threaded mode, see set_threaded().
+     */
+    static bool is_threaded();
+
+    /**
+     * get the virtual time since the start of the program (us), the real time in the threaded mode.
+     */
+    static uint64_t now_us();
+
+    /**
+     * let the other tasks, the timers and the events run for a virtual time.
+     * Same as a vTaskDelay() of the caller, but with us resolution.
+     * @param us: virtual time (us).
+     */
+    static void run_for( uint64_t us );
+
+    /**
+     * let the other tasks, the timers and the events run until a virtual time.
+     * Returns at once if the time has passed.
+     * @param time_us: virtual time (us).
+     */
+    static void run_until( uint64_t time_us );
+
+    /**
+     * call a function at a virtual time in interrupt context, like an interrupt service routine.
+     * xPortInIsrContext() is true while it runs, it must not block.
+     * @param time_us: virtual time (us), a past time is taken as now.
+     * @param fn: function called.
+     * @param arg: argument of the function.
+     */
+    static void at( uint64_t time_us, event_fn_t fn, void *arg = nullptr );
+
+    /**
+     * get the edges recorded since the start or clear_edges(), in the order of their time.
+     * In the threaded mode the edges must not change meanwhile, for ex. after end() of all LEDs.
+     */
+    static const std::vector<edge_t> & get_edges();
+
+    /**
+     * forget the edges recorded so far.
+     */
+    static void clear_edges();
+
+    /**
+     * get the current level of a gpio pin. All pins are LOW at the start.
+     */
+    static bool get_level( int pin );
+
+    /**
+     * call a function for each edge when it is recorded, for ex. to write a trace file, see GLedVcd.
+     * @param listener: function called, nullptr to remove it.
+     * @param arg: argument of the function.
+     */
+    static void set_edge_listener( edge_listener_t listener, void *arg = nullptr );
+
+    /**
+     * set the highest level of the ESP_LOGx output, ESP_LOG_ERROR by default.
+     * The lines are prefixed with the virtual time and the task.
+     */
+    static void set_log_level( esp_log_level_t level );
+
+    /**
+     * get the number of tasks created and not yet deleted, without "main" and other threads of the program.
+     */
+    static unsigned get_tasks();
+};
+
+#endif
+
+// eof
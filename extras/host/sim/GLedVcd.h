@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       pin transitions of the host simulation written to a VCD file.
+// premises:	   host compiler, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedVcd.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_VCD_HEADER_H
+#define GLED_VCD_HEADER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <soc/soc_caps.h>
+#include <vector>
+
+#include "GLedSim.h"
+
+/**
+ * The GLedVcd writes the pin transitions of a GLedSim run to a value change dump (VCD) file,
+ * which can be viewed with GTKWave. Every gpio edge is written, no matter whether a GLed,
+ * a GLedGroup or a GLedMatrix drives the pin. The time unit is 1 us.
+ * \n
+ * The file has no date, so two runs of the same scenario write identical files and
+ * the waveforms of two library versions can be compared with diff.
+ * The changes are written through a file buffer of BUFFER_SIZE bytes,
+ * the buffer is flushed by close() or the destructor.
+ * \n
+ * The GLedVcd takes the edge listener of the GLedSim while the file is open.
+ * \n
+ * Example:
+ * \code
+ * GLed status( 4 ), error( 5 );
+ * GLedVcd vcd;
+ *
+ * vcd.add_pin( 4, "status" );
+ * vcd.add_pin( 5, "error" );
+ * vcd.open( "leds.vcd" );
+ * status.begin();
+ * error.begin();
+ * status.async_flash( GLed::FLASH_FOR_EVER, 100, 900 );
+ * error.async_flash( 3, 50, 50 );
+ * GLedSim::run_for( 10000000 );
+ * vcd.close();
+ * \endcode
+ */
+class GLedVcd {
+public:
+    static const size_t BUFFER_SIZE = 65536;   ///< size of the file buffer [bytes]
+
+    GLedVcd()
+        : file(nullptr)
+        , buffer(BUFFER_SIZE)
+        , traced(0)
+        , time(0)
+        , changes(0)
+    {
+        for( int n = 0; n < SOC_GPIO_PIN_COUNT; n++ )
+            name[n] = nullptr;
+    }
+
+    ~GLedVcd()
+    {
+        close();
+    }
+
+    /**
+     * trace a pin. Without any added pin all gpio pins are traced. Call it before open().
+     * @param pin: gpio number.
+     * @param a_name: name of the signal, "gpio<n>" if nullptr. The string is not copied.
+     */
+    void add_pin( int pin, const char *a_name = nullptr )
+    {
+        if( pin < 0 || pin >= SOC_GPIO_PIN_COUNT )
+            return;
+        traced |= 1ull << pin;
+        name[pin] = a_name;
+    }
+
+    /**
+     * create the file, write the definitions and the current levels and start tracing.
+     * @param path: file name.
+     * @param scope: name of the module in the waveform viewer.
+     * @return false if the file can not be created.
+     */
+    bool open( const char *path, const char *scope = "gled" )
+    {
+        close();
+        if( (file = fopen( path, "w" )) == nullptr )
+            return false;
+        setvbuf( file, buffer.data(), _IOFBF, buffer.size() );
+        if( traced == 0 )
+            traced = (SOC_GPIO_PIN_COUNT < 64 ? 1ull << SOC_GPIO_PIN_COUNT : 0) - 1;
+
+        fprintf( file, "$version GLedSim $end\n$timescale 1us $end\n$scope module %s $end\n", scope );
+        for( int n = 0; n < SOC_GPIO_PIN_COUNT; n++ ) {
+            if( ! is_traced( n ) )
+                continue;
+            if( name[n] != nullptr )
+                fprintf( file, "$var wire 1 %c %s $end\n", id( n ), name[n] );
+            else
+                fprintf( file, "$var wire 1 %c gpio%d $end\n", id( n ), n );
+        }
+        fprintf( file, "$upscope $end\n$enddefinitions $end\n" );
+
+        time = GLedSim::now_us();
+        fprintf( file, "#%" PRIu64 "\n$dumpvars\n", time );
+        for( int n = 0; n < SOC_GPIO_PIN_COUNT; n++ )
+            if( is_traced( n ) )
+                fprintf( file, "%d%c\n", (int) GLedSim::get_level( n ), id( n ) );
+        fprintf( file, "$end\n" );
+
+        GLedSim::set_edge_listener( on_edge, this );
+        return true;
+    }
+
+    /**
+     * stop tracing, write the end time and close the file.
+     */
+    void close()
+    {
+        if( file == nullptr )
+            return;
+        GLedSim::set_edge_listener( nullptr );
+        // the end time, so a viewer shows the last levels up to now:
+        const uint64_t now = GLedSim::now_us();
+        if( now != time )
+            fprintf( file, "#%" PRIu64 "\n", now );
+        fclose( file );
+        file = nullptr;
+    }
+
+    /**
+     * get the number of changes written since open().
+     */
+    uint64_t get_changes() const { return changes; }
+
+private:
+    FILE * file;
+    std::vector<char> buffer;
+    uint64_t traced;                         ///< bit n: gpio n is traced.
+    const char * name[SOC_GPIO_PIN_COUNT];
+    uint64_t time;                           ///< time of the last change written.
+    uint64_t changes;
+
+    bool is_traced( int pin ) const { return (traced >> pin) & 1; }
+
+    /// identifier of a pin in the file, one printable character.
+    static char id( int pin ) { return (char) ('!' + pin); }
+
+    static void on_edge( const GLedSim::edge_t & edge, void *arg )
+    {
+        GLedVcd * vcd = (GLedVcd*) arg;
+
+        if( ! vcd->is_traced( edge.pin ) )
+            return;
+        if( edge.time_us != vcd->time ) {
+            vcd->time = edge.time_us;
+            fprintf( vcd->file, "#%" PRIu64 "\n", edge.time_us );
+        }
+        fprintf( vcd->file, "%d%c\n", (int) edge.level, id( edge.pin ) );
+        vcd->changes++;
+    }
+};
+
+#endif
+
+// eof
@@ -0,0 +1,31 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       gpio driver subset for host simulation.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           gpio.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_GPIO_HEADER_H
+#define GLED_SIM_GPIO_HEADER_H
+
+#include <Arduino.h>
+
+typedef int gpio_num_t;
+
+#endif
+
+// eof
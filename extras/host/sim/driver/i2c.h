@@ -0,0 +1,37 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       I2C master driver subset for host simulation, no device answers.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           i2c.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_I2C_HEADER_H
+#define GLED_SIM_I2C_HEADER_H
+
+#include <Arduino.h>
+
+typedef int i2c_port_t;
+
+#define I2C_NUM_0 0
+#define I2C_NUM_1 1
+
+esp_err_t i2c_master_write_to_device( i2c_port_t port, uint8_t address, const uint8_t *data, size_t len,
+                                      TickType_t ticks );
+
+#endif
+
+// eof
@@ -0,0 +1,40 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       RTC gpio subset for host simulation, the RTC gpios of the ESP32.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           rtc_io.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_RTC_IO_HEADER_H
+#define GLED_SIM_RTC_IO_HEADER_H
+
+#include <Arduino.h>
+#include <driver/gpio.h>
+
+typedef enum { RTC_GPIO_MODE_INPUT_ONLY, RTC_GPIO_MODE_OUTPUT_ONLY, RTC_GPIO_MODE_INPUT_OUTPUT } rtc_gpio_mode_t;
+
+bool rtc_gpio_is_valid_gpio( gpio_num_t gpio );
+/// RTC io number of a gpio, -1 if it is no RTC gpio.
+int rtc_io_number_get( gpio_num_t gpio );
+esp_err_t rtc_gpio_init( gpio_num_t gpio );
+esp_err_t rtc_gpio_deinit( gpio_num_t gpio );
+esp_err_t rtc_gpio_set_direction( gpio_num_t gpio, rtc_gpio_mode_t mode );
+esp_err_t rtc_gpio_set_level( gpio_num_t gpio, uint32_t level );
+
+#endif
+
+// eof
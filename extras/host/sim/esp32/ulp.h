@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       ULP FSM coprocessor subset for host simulation, the instructions used by GLedUlp.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           ulp.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_ULP_HEADER_H
+#define GLED_SIM_ULP_HEADER_H
+
+#include <Arduino.h>
+
+enum { R0, R1, R2, R3 };
+
+// instructions of the simulated ULP, the macros below build them.
+enum {
+    GLED_SIM_ULP_MOVI, GLED_SIM_ULP_LD, GLED_SIM_ULP_ST, GLED_SIM_ULP_SUBI, GLED_SIM_ULP_BGE, GLED_SIM_ULP_BL,
+    GLED_SIM_ULP_LABEL, GLED_SIM_ULP_WR_REG, GLED_SIM_ULP_SLEEP, GLED_SIM_ULP_HALT, GLED_SIM_ULP_END
+};
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t rd;        ///< destination, or the value register of I_ST.
+    uint8_t rs;        ///< source, or the address register of I_LD and I_ST.
+    int32_t imm;       ///< immediate, offset [words], branch threshold, register value or period index.
+    uint32_t arg;      ///< register address of I_WR_REG, label of the branches.
+    uint8_t low;       ///< lowest bit of I_WR_REG.
+    uint8_t high;      ///< highest bit of I_WR_REG.
+} ulp_insn_t;
+
+#define I_MOVI( rd, imm )                   { GLED_SIM_ULP_MOVI, rd, 0, imm, 0, 0, 0 }
+#define I_LD( rd, rs, offset )              { GLED_SIM_ULP_LD, rd, rs, offset, 0, 0, 0 }
+#define I_ST( rval, raddr, offset )         { GLED_SIM_ULP_ST, rval, raddr, offset, 0, 0, 0 }
+#define I_SUBI( rd, rs, imm )               { GLED_SIM_ULP_SUBI, rd, rs, imm, 0, 0, 0 }
+#define M_BGE( label, imm )                 { GLED_SIM_ULP_BGE, 0, 0, imm, label, 0, 0 }
+#define M_BL( label, imm )                  { GLED_SIM_ULP_BL, 0, 0, imm, label, 0, 0 }
+#define M_LABEL( label )                    { GLED_SIM_ULP_LABEL, 0, 0, 0, label, 0, 0 }
+#define I_WR_REG( reg, low, high, val )     { GLED_SIM_ULP_WR_REG, 0, 0, val, (uint32_t) (reg), (uint8_t) (low), (uint8_t) (high) }
+#define I_SLEEP_CYCLE_SEL( index )          { GLED_SIM_ULP_SLEEP, 0, 0, index, 0, 0, 0 }
+#define I_HALT()                            { GLED_SIM_ULP_HALT, 0, 0, 0, 0, 0, 0 }
+#define I_END()                             { GLED_SIM_ULP_END, 0, 0, 0, 0, 0, 0 }
+
+/// RTC slow memory of the simulation, 2048 words. The ULP program is kept apart from it.
+extern uint32_t gled_sim_rtc_slow_mem[];
+#define RTC_SLOW_MEM gled_sim_rtc_slow_mem
+
+esp_err_t ulp_process_macros_and_load( uint32_t load_addr, const ulp_insn_t *program, size_t *psize );
+esp_err_t ulp_run( uint32_t entry_point );
+esp_err_t ulp_set_wakeup_period( size_t period_index, uint32_t period_us );
+
+#endif
+
+// eof
@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       sleep mode subset for host simulation, the simulated chip never sleeps.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           esp_sleep.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_ESP_SLEEP_HEADER_H
+#define GLED_SIM_ESP_SLEEP_HEADER_H
+
+#include <Arduino.h>
+
+typedef enum { ESP_PD_DOMAIN_RTC_PERIPH } esp_sleep_pd_domain_t;
+typedef enum { ESP_PD_OPTION_OFF, ESP_PD_OPTION_ON, ESP_PD_OPTION_AUTO } esp_sleep_pd_option_t;
+
+inline esp_err_t esp_sleep_pd_config( esp_sleep_pd_domain_t, esp_sleep_pd_option_t ) { return ESP_OK; }
+
+#endif
+
+// eof
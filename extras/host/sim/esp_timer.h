@@ -0,0 +1,48 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       esp_timer on the virtual clock of the host simulation.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           esp_timer.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_ESP_TIMER_HEADER_H
+#define GLED_SIM_ESP_TIMER_HEADER_H
+
+#include <Arduino.h>
+
+typedef void * esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)( void *arg );
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create( const esp_timer_create_args_t *args, esp_timer_handle_t *handle );
+esp_err_t esp_timer_start_once( esp_timer_handle_t timer, uint64_t timeout_us );
+esp_err_t esp_timer_start_periodic( esp_timer_handle_t timer, uint64_t period_us );
+esp_err_t esp_timer_stop( esp_timer_handle_t timer );
+esp_err_t esp_timer_delete( esp_timer_handle_t timer );
+int64_t esp_timer_get_time();
+
+#endif
+
+// eof
@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       FreeRTOS event groups for host simulation.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           event_groups.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_EVENT_GROUPS_HEADER_H
+#define GLED_SIM_EVENT_GROUPS_HEADER_H
+
+#include <Arduino.h>
+
+typedef void * EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate();
+EventBits_t xEventGroupSetBits( EventGroupHandle_t group, EventBits_t bits );
+EventBits_t xEventGroupClearBits( EventGroupHandle_t group, EventBits_t bits );
+EventBits_t xEventGroupGetBits( EventGroupHandle_t group );
+EventBits_t xEventGroupWaitBits( EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                 BaseType_t wait_for_all, TickType_t ticks );
+
+#endif
+
+// eof
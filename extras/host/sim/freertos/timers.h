@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       FreeRTOS timer task for host simulation, pended function calls only.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           timers.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_TIMERS_HEADER_H
+#define GLED_SIM_TIMERS_HEADER_H
+
+#include <Arduino.h>
+
+// a function called by the timer task, see xTimerPendFunctionCallFromISR().
+typedef void (*PendedFunction_t)( void *param1, uint32_t param2 );
+
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t function, void *param1, uint32_t param2,
+                                          BaseType_t *task_woken );
+
+#endif
+
+// eof
@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       gpio output registers of the ESP32 for host simulation.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           gpio_reg.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_GPIO_REG_HEADER_H
+#define GLED_SIM_GPIO_REG_HEADER_H
+
+#define DR_REG_GPIO_BASE            0x3ff44000
+#define GPIO_OUT_REG                (DR_REG_GPIO_BASE + 0x0004)
+#define GPIO_OUT_W1TS_REG           (DR_REG_GPIO_BASE + 0x0008)
+#define GPIO_OUT_W1TC_REG           (DR_REG_GPIO_BASE + 0x000c)
+#define GPIO_OUT1_REG               (DR_REG_GPIO_BASE + 0x0010)
+#define GPIO_OUT1_W1TS_REG          (DR_REG_GPIO_BASE + 0x0014)
+#define GPIO_OUT1_W1TC_REG          (DR_REG_GPIO_BASE + 0x0018)
+
+#endif
+
+// eof
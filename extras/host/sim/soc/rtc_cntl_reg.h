@@ -0,0 +1,33 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       RTC control registers of the host simulation, the ULP timer enable only.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           rtc_cntl_reg.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_RTC_CNTL_REG_HEADER_H
+#define GLED_SIM_RTC_CNTL_REG_HEADER_H
+
+#include <soc/soc.h>
+
+#define DR_REG_RTCCNTL_BASE             0x3ff48000
+#define RTC_CNTL_STATE0_REG             (DR_REG_RTCCNTL_BASE + 0x0018)
+#define RTC_CNTL_ULP_CP_SLP_TIMER_EN    (1u << 24)
+
+#endif
+
+// eof
@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       RTC gpio registers of the host simulation, the output set and clear registers only.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           rtc_io_reg.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_RTC_IO_REG_HEADER_H
+#define GLED_SIM_RTC_IO_REG_HEADER_H
+
+#include <soc/soc.h>
+
+#define DR_REG_RTCIO_BASE               0x3ff48400
+#define RTC_GPIO_OUT_W1TS_REG           (DR_REG_RTCIO_BASE + 0x0004)
+#define RTC_GPIO_OUT_W1TC_REG           (DR_REG_RTCIO_BASE + 0x0008)
+#define RTC_GPIO_OUT_DATA_W1TS_S        14
+
+#endif
+
+// eof
@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       register access of the host simulation, gpio output and ULP timer registers only.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           soc.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_SOC_HEADER_H
+#define GLED_SIM_SOC_HEADER_H
+
+#include <stdint.h>
+
+/// write a peripheral register, the gpio output registers change the simulated pin levels,
+/// RTC_CNTL_STATE0_REG starts and stops the ULP timer.
+void gled_sim_reg_write( uint32_t reg, uint32_t value );
+/// read a peripheral register, the gpio output registers return the simulated pin levels.
+uint32_t gled_sim_reg_read( uint32_t reg );
+
+#define REG_WRITE( reg, value )     gled_sim_reg_write( (uint32_t) (reg), (uint32_t) (value) )
+#define REG_READ( reg )             gled_sim_reg_read( (uint32_t) (reg) )
+#define CLEAR_PERI_REG_MASK( reg, mask ) REG_WRITE( (reg), REG_READ( reg ) & ~(mask) )
+
+#define APB_CLK_FREQ                80000000
+
+#endif
+
+// eof
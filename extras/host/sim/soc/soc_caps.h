@@ -0,0 +1,30 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       capabilities of the simulated chip, an ESP32 without the optional peripherals.
+// premises:	   host compiler, no hardware, see GLedSim.h.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           soc_caps.h
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SIM_SOC_CAPS_HEADER_H
+#define GLED_SIM_SOC_CAPS_HEADER_H
+
+#define SOC_GPIO_PIN_COUNT          40
+#define SOC_LEDC_CHANNEL_NUM        8
+
+#endif
+
+// eof
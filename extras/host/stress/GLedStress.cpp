@@ -0,0 +1,265 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       concurrency stress of the GLed switching methods for the thread sanitizer.
+// premises:	   host compiler with -fsanitize=thread, see extras/host/sim/GLedSim.h.
+// remarks:        build and run from the root of the library, with the thread sanitizer:
+//                 g++ -std=gnu++17 -g -O1 -fsanitize=thread -Iextras/host/sim -Isrc -o gled_stress extras/host/stress/GLedStress.cpp
+//                     src/GLed.cpp src/GLedPattern.cpp src/GLedGpio.cpp extras/host/sim/GLedSim.cpp -lpthread
+//                 or with the address sanitizer: -fsanitize=address,undefined instead of -fsanitize=thread.
+//                 ./gled_stress [--seconds n] [--threads n] [--unsafe]
+//                 The exit code is 1 if a worker hangs, a flash task is left over or a pin does not match its LED,
+//                 the sanitizer reports the races and the memory errors itself.
+//                 Each LED is configured by one worker only. The others keep switching it during end(),
+//                 but keep off while it is moved by reconnect_to_pin(), the configuration is not thread save.
+//                 --unsafe lets every thread call end() and reconnect_to_pin() at any time,
+//                 to show what the sanitizer reports then.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedStress.cpp
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "GLed.h"
+#include "GLedSim.h"
+
+static const unsigned LEDS = 4;
+static const int pins[LEDS] = { 4, 5, 6, 7 };
+static const int other_pins[LEDS] = { 12, 13, 14, 15 };   // reconnect_to_pin() alternates.
+static const uint64_t HANG_US = 5000000;                   // a worker not done by then hangs.
+
+enum op_t { OP_ASYNC_FLASH, OP_TIME_REGIME, OP_TOGGLE, OP_TOGGLE_FROM_ISR, OP_END, OP_RECONNECT, OP_COUNT };
+static const char * const op_names[OP_COUNT] = {
+	"async_flash", "async_flash_set_time_regime", "toggle", "toggle_from_isr", "end", "reconnect_to_pin"
+};
+
+static GLed * leds[LEDS];
+static std::atomic<bool> quit( false );
+static std::atomic<unsigned> active( 0 );
+static std::atomic<uint64_t> ops[OP_COUNT];
+static std::atomic<unsigned> users[LEDS];   // workers and ISRs switching a LED.
+static std::atomic<bool> parked[LEDS];      // the LED is moved to another pin, the others keep off.
+static bool unsafe = false;
+
+typedef struct {
+	uint32_t seed;
+	int led;                    // LED configured by this task, -1 for none.
+	std::atomic<int> op;        // operation in progress, -1 when done.
+	std::atomic<unsigned> n;    // LED of the operation.
+} worker_t;
+
+static uint32_t next_random( uint32_t & x )
+{
+	// xorshift32
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+// start switching a LED, false if it is parked. Not needed with --unsafe.
+static bool use( unsigned n )
+{
+	if( unsafe )
+		return true;
+	users[n]++;
+	if( ! parked[n] )
+		return true;
+	users[n]--;
+	return false;
+}
+
+static void done( unsigned n )
+{
+	if( ! unsafe )
+		users[n]--;
+}
+
+static void isr_toggle( void *arg )
+{
+	const unsigned n = (uintptr_t) arg;
+
+	if( use( n ) ) {
+		leds[n]->toggle_from_isr();
+		done( n );
+	}
+}
+
+// end or move a LED and activate it again, only one task per LED unless --unsafe.
+static void configure( worker_t & w, unsigned n, uint32_t & seed )
+{
+	GLed & led = *leds[n];
+
+	w.n = n;
+	if( next_random( seed ) & 1 ) {
+		w.op = OP_END;
+		led.end();
+		led.begin();
+		ops[OP_END]++;
+	}
+	else {
+		w.op = OP_RECONNECT;
+		if( ! unsafe ) {
+			parked[n] = true;
+			while( users[n] > 0 )
+				taskYIELD();
+		}
+		led.reconnect_to_pin( led.get_pin() == pins[n] ? other_pins[n] : pins[n] );
+		led.begin();
+		parked[n] = false;
+		ops[OP_RECONNECT]++;
+	}
+}
+
+static void task_worker( void *pvParameters )
+{
+	worker_t * w = (worker_t*) pvParameters;
+	uint32_t seed = w->seed;
+
+	while( ! quit ) {
+		const unsigned n = next_random( seed ) % LEDS;
+		const unsigned k = next_random( seed ) % 8;
+		GLed & led = *leds[n];
+
+		w->n = n;
+		if( k == 7 ) {
+			if( w->led >= 0 )
+				configure( *w, w->led, seed );
+			else if( unsafe )
+				configure( *w, n, seed );
+			vTaskDelay( 1 );   // let the flash tasks run.
+			continue;
+		}
+		if( k == 6 ) {
+			w->op = OP_TOGGLE_FROM_ISR;
+			GLedSim::at( GLedSim::now_us() + next_random( seed ) % 2000, isr_toggle, (void*) (uintptr_t) n );
+			ops[OP_TOGGLE_FROM_ISR]++;
+			continue;
+		}
+		if( ! use( n ) )
+			continue;
+		if( k < 2 ) {
+			w->op = OP_ASYNC_FLASH;
+			led.async_flash( 1 + next_random( seed ) % 20, 1 + next_random( seed ) % 5, 1 + next_random( seed ) % 5 );
+			ops[OP_ASYNC_FLASH]++;
+		}
+		else if( k < 4 ) {
+			w->op = OP_TIME_REGIME;
+			led.async_flash_set_time_regime( 1 + next_random( seed ) % 5, 1 + next_random( seed ) % 5 );
+			ops[OP_TIME_REGIME]++;
+		}
+		else {
+			w->op = OP_TOGGLE;
+			led.toggle();
+			ops[OP_TOGGLE]++;
+		}
+		done( n );
+	}
+	w->op = -1;
+	active--;
+	vTaskDelete( NULL );
+}
+
+int main( int argc, char *argv[] )
+{
+	unsigned seconds = 5;
+	unsigned threads = 8;
+
+	for( int i = 1; i < argc; i++ ) {
+		const std::string arg = argv[i];
+		if( arg == "--seconds" && i + 1 < argc )
+			seconds = atoi( argv[++i] );
+		else if( arg == "--threads" && i + 1 < argc )
+			threads = atoi( argv[++i] );
+		else if( arg == "--unsafe" )
+			unsafe = true;
+		else {
+			fprintf( stderr, "usage: %s [--seconds n] [--threads n] [--unsafe]\n", argv[0] );
+			return 2;
+		}
+	}
+
+	GLedSim::set_threaded( true );
+	for( unsigned n = 0; n < LEDS; n++ ) {
+		leds[n] = new GLed( pins[n] );
+		leds[n]->begin();
+	}
+
+	// the first LEDS workers configure one LED each, the configuration is not thread save:
+	std::vector<worker_t> workers( threads );
+	for( unsigned i = 0; i < threads; i++ ) {
+		workers[i].seed = 2463534242u + 7919u * i;
+		workers[i].led = i < LEDS && ! unsafe ? (int) i : -1;
+		workers[i].op = -1;
+		workers[i].n = 0;
+		active++;
+		xTaskCreatePinnedToCore( task_worker, "task_worker", 4096, &workers[i], 1, nullptr, i % portNUM_PROCESSORS );
+	}
+
+	GLedSim::run_for( (uint64_t) seconds * 1000000 );
+	quit = true;
+	const uint64_t deadline = GLedSim::now_us() + HANG_US;
+	while( active > 0 && GLedSim::now_us() < deadline )
+		GLedSim::run_for( 1000 );
+
+	uint64_t total = 0;
+	for( unsigned i = 0; i < OP_COUNT; i++ ) {
+		printf( "%-28s %10" PRIu64 "\n", op_names[i], ops[i].load() );
+		total += ops[i];
+	}
+	printf( "%-28s %10" PRIu64 " (%" PRIu64 " per s, %u threads)\n", "total", total, total / (seconds > 0 ? seconds : 1), threads );
+	if( active > 0 ) {
+		// the threads of the hanging workers can not be stopped, so no clean up:
+		for( unsigned i = 0; i < threads; i++ ) {
+			const int op = workers[i].op;
+			if( op >= 0 )
+				printf( "FAILED: task_worker %u hangs in %s() of LED %u\n", i, op_names[op], workers[i].n.load() );
+		}
+		fflush( stdout );
+		_exit( 1 );
+	}
+	GLedSim::run_for( 10000 );   // the ISR events scheduled last.
+
+	for( unsigned n = 0; n < LEDS; n++ )
+		leds[n]->end();
+	GLedSim::run_for( 10000 );
+
+	printf( "%-28s %10zu\n", "edges", GLedSim::get_edges().size() );
+	printf( "%-28s %10u\n", "elided writes", GLed::get_elided_writes() );
+
+	// after end() each LED is dark and no task is left, toggle_from_isr() needs no task_gled_isr:
+	int rc = 0;
+	const unsigned tasks = GLedSim::get_tasks();
+	if( tasks != 0 ) {
+		printf( "FAILED: %u tasks left, none expected\n", tasks );
+		rc = 1;
+	}
+	for( unsigned n = 0; n < LEDS; n++ ) {
+		const int pin = leds[n]->get_pin();
+		if( GLedSim::get_level( pin ) != (leds[n]->get_logic_mode() == GLed::LOW_IS_ACTIVE) ) {
+			printf( "FAILED: LED %u, gpio%d is %d after end()\n", n, pin, (int) GLedSim::get_level( pin ) );
+			rc = 1;
+		}
+	}
+	if( rc == 0 )
+		printf( "ok\n" );
+	return rc;
+}
+
+// eof
@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       hand over of a flash sequence to the simulated ULP on the host.
+// premises:	   host compiler, see extras/host/sim/GLedSim.h.
+// remarks:        build and run from the root of the library, GLedUlp.cpp needs the ESP32 with the ULP:
+//                 g++ -std=gnu++17 -DCONFIG_IDF_TARGET_ESP32=1 -DCONFIG_ULP_COPROC_ENABLED=1 -Iextras/host/sim -Isrc
+//                     -o gled_ulp extras/host/ulp/GLedUlpRun.cpp src/GLed.cpp src/GLedPattern.cpp src/GLedGpio.cpp
+//                     src/GLedUlp.cpp extras/host/sim/GLedSim.cpp -lpthread
+//                 ./gled_ulp                    exit code 1 if a check fails.
+//                 resume() is not checked, the ULP cycle start is taken from the real system time.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedUlpRun.cpp
+// language:       C++
+// compiler:       g++
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLed.h"
+#include "GLedSim.h"
+#include "GLedUlp.h"
+
+static const int PIN = 4;             // a RTC gpio.
+static const unsigned DT_ON = 100;
+static const unsigned DT_OFF = 200;
+
+typedef struct {
+	const char * name;
+	bool (*run)();
+} scenario_t;
+
+static bool check( bool condition, const char *what )
+{
+	if( ! condition )
+		printf( "\n  %s", what );
+	return condition;
+}
+
+// the rising edges of the pin, relative to start [ms], since clear_edges().
+static std::vector<unsigned> flashes( uint64_t start )
+{
+	std::vector<unsigned> t;
+
+	for( const GLedSim::edge_t & e : GLedSim::get_edges() )
+		if( e.pin == PIN && e.level )
+			t.push_back( (unsigned) ((e.time_us - start) / 1000) );
+	return t;
+}
+
+// async_flash( 3 ) handed to the ULP at a time: the ULP plays the rest in phase, 3 flashes in total.
+static bool handover( unsigned at_ms, esp_err_t expected )
+{
+	GLed led( PIN );
+	bool ok = true;
+
+	led.begin();
+	GLedSim::clear_edges();
+	const uint64_t start = GLedSim::now_us();
+	led.async_flash( 3, DT_ON, DT_OFF );
+	GLedSim::run_for( at_ms * 1000 );
+	ok &= check( GLedUlp::start( led ) == expected, "unexpected result of GLedUlp::start()" );
+	GLedSim::run_for( 3 * (DT_ON + DT_OFF) * 1000 );
+
+	const std::vector<unsigned> t = flashes( start );
+	ok &= check( t.size() == 3, "not 3 flashes in total" );
+	for( unsigned i = 0; i < t.size() && i < 3; i++ )
+		ok &= check( t[i] == i * (DT_ON + DT_OFF), "flash out of phase" );
+	ok &= check( ! GLedSim::get_level( PIN ), "LED not dark after the last flash" );
+
+	led.end();
+	return ok;
+}
+
+static bool handover_on_step() { return handover( DT_ON / 2, ESP_OK ); }
+static bool handover_off_step() { return handover( DT_ON + DT_OFF / 2, ESP_OK ); }
+static bool handover_last_off_step() { return handover( 2 * (DT_ON + DT_OFF) + DT_ON + DT_OFF / 2, ESP_OK ); }
+
+// a new sequence on the ULP starts with the on time.
+static bool start_count()
+{
+	GLed led( PIN );
+	bool ok = true;
+
+	led.begin();
+	GLedSim::clear_edges();
+	const uint64_t start = GLedSim::now_us();
+	ok &= check( GLedUlp::start( led, 3, DT_ON, DT_OFF ) == ESP_OK, "GLedUlp::start( 3 ) failed" );
+	GLedSim::run_for( 4 * (DT_ON + DT_OFF) * 1000 );
+	ok &= check( flashes( start ).size() == 3, "not 3 flashes by GLedUlp::start( 3 )" );
+	ok &= check( ! GLedSim::get_level( PIN ), "LED not dark after the last flash" );
+
+	led.end();
+	return ok;
+}
+
+static const scenario_t scenarios[] = {
+	{ "handover_on_step", handover_on_step },
+	{ "handover_off_step", handover_off_step },
+	{ "handover_last_off_step", handover_last_off_step },
+	{ "start_count", start_count },
+};
+
+int main()
+{
+	unsigned failed = 0;
+
+	for( const scenario_t & s : scenarios ) {
+		printf( "%-24s", s.name );
+		fflush( stdout );
+		if( s.run() )
+			printf( " ok\n" );
+		else {
+			printf( "\n%-24s FAILED\n", "" );
+			failed++;
+		}
+	}
+	return failed > 0 ? 1 : 0;
+}
+
+// eof
@@ -25,15 +25,102 @@
 //
 
 #include <Arduino.h>
+#include <driver/gpio.h>
+#include <soc/soc_caps.h>
+#include <freertos/timers.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && SOC_SDM_SUPPORTED
+#include <driver/sdm.h>
+#define GLED_SDM_CHANNELS SOC_SDM_CHANNELS_PER_GROUP
+#elif ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0) && defined(SOC_SIGMADELTA_CHANNEL_NUM)
+#include <driver/sigmadelta.h>
+#define GLED_SDM_CHANNELS SOC_SIGMADELTA_CHANNEL_NUM
+#else
+#define GLED_SDM_CHANNELS 0
+#endif
 
 #include "GLed.h"
+#include "GLedGpio.h"
 
-typedef struct { GLed * pGLed; } task_args_t;
+// requests handled by task_gled_isr, mostly sent by an ISR:
+enum isr_request_id_t { REQUEST_FADE_END, REQUEST_FLASH };
+typedef struct { GLed * pGLed; uint8_t request; } isr_request_t;
 
 void task_flash( void *pvParameters );
+void task_gled_isr( void *pvParameters );
+bool on_fade_end( const ledc_cb_param_t *param, void *user_arg );
 
 static const char* TAG = "GLED";
 
+static uint32_t ledc_channels_used = 0;        // bit n set: LEDC channel n is assigned to a GLed.
+static bool ledc_ready = false;                // LEDC timer and fade service installed.
+static uint32_t sdm_channels_used = 0;         // bit n set: sigma-delta channel n is assigned to a GLed.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && GLED_SDM_CHANNELS > 0
+static sdm_channel_handle_t sdm_handles[GLED_SDM_CHANNELS];   // created while the channel drives its pin.
+#endif
+static QueueHandle_t isr_queue = nullptr;      // requests for task_gled_isr.
+static TaskHandle_t isr_task_handle = nullptr;
+static std::atomic<bool> isr_task_started { false };   // task_gled_isr is created or its start is pended.
+static std::atomic<uint32_t> isr_requests_lost { 0 };   // the queue was full, logged by task_gled_isr.
+
+// power management: the locks are taken only while they are needed, so automatic light sleep
+// can run between the edges.
+#if CONFIG_PM_ENABLE
+static std::atomic<esp_pm_lock_handle_t> pm_edge_lock { nullptr };   // full cpu speed while an edge is processed.
+static std::atomic<esp_pm_lock_handle_t> pm_ledc_lock { nullptr };   // no light sleep while the LEDC drives a LED.
+#define GLED_PM_ACQUIRE( lock ) do { if( lock != nullptr ) esp_pm_lock_acquire( lock ); } while(0)
+#define GLED_PM_RELEASE( lock ) do { if( lock != nullptr ) esp_pm_lock_release( lock ); } while(0)
+#else
+#define GLED_PM_ACQUIRE( lock )
+#define GLED_PM_RELEASE( lock )
+#endif
+
+volatile TickType_t GLed::wake_alignment = 0;
+
+#if CONFIG_PM_ENABLE
+// create a power management lock, a caller which loses the race drops its own.
+static void init_pm_lock( std::atomic<esp_pm_lock_handle_t> & lock, esp_pm_lock_type_t type, const char *name )
+{
+	esp_pm_lock_handle_t handle = nullptr;
+
+	if( lock != nullptr || esp_pm_lock_create( type, 0, name, &handle ) != ESP_OK )
+		return;
+	esp_pm_lock_handle_t none = nullptr;
+	if( ! lock.compare_exchange_strong( none, handle ) )
+		esp_pm_lock_delete( handle );
+}
+#endif
+
+// create the power management locks with the first flash task or dimmer.
+static void init_pm_locks()
+{
+#if CONFIG_PM_ENABLE
+	init_pm_lock( pm_edge_lock, ESP_PM_CPU_FREQ_MAX, "gled_edge" );
+	init_pm_lock( pm_ledc_lock, ESP_PM_NO_LIGHT_SLEEP, "gled_ledc" );
+#endif
+}
+
+// create the queue of the requests of interrupt service routines, an ISR can not create it.
+static esp_err_t init_isr_queue()
+{
+	if( isr_queue == nullptr )
+		isr_queue = xQueueCreate( 16, sizeof(isr_request_t) );
+	return isr_queue != nullptr ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// start the task shared by all LEDs, which handles the requests of interrupt service routines.
+// The first request pends the start to the FreeRTOS timer task, so an application which never
+// sends one does without its stack.
+static void start_isr_task( void *, uint32_t )
+{
+	if( xTaskCreatePinnedToCore( task_gled_isr, "task_gled_isr", 2048, nullptr, 2, & isr_task_handle, FLASH_TASK_CORE ) != pdPASS ) {
+		ESP_LOGE( TAG, "task_gled_isr not started, the ISR requests wait in the queue" );
+		isr_task_started = false;   // the next request tries again.
+	}
+}
+
 GLed::~GLed()
 {
 	end();
@@ -42,20 +129,46 @@ GLed::~GLed()
 void GLed::begin()
 {
 	ESP_LOGW( TAG, "LED (%d) activated, lights up if gpio%d is %d", pin, pin, get_logic_mode() == HIGH_IS_ACTIVE );
-    pinMode(pin, OUTPUT);
+    if( backend != nullptr ) {
+    	if( backend->attach( pin ) != ESP_OK ) {
+    		ESP_LOGE( TAG, "LED (%d) channel not available", pin );
+    		return;
+    	}
+    }
+    else {
+    	pinMode(pin, OUTPUT);
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+    	gpio_sleep_sel_dis( (gpio_num_t) pin );   // the pin keeps its level during light sleep.
+#endif
+    }
+    if( init_isr_queue() != ESP_OK )
+    	ESP_LOGE( TAG, "LED (%d) no queue for task_gled_isr, ISR requests are ignored", pin );
     activated = true;
-    off();
+    state = 0;
+    write_state( 0, true );   // the level of the pin is unknown before.
 }
 
 void GLed::end()
 {
 	ESP_LOGW( TAG, "LED (%d) disabled", pin );
-	if( flash_task_handle != nullptr ) {
-		vTaskDelete(flash_task_handle );
+	// no flash task gets started any more, a running one terminates:
+	const bool was_activated = activated.exchange( false );
+	stop_flash_task();
+	stop_layers();
+	activity_enabled = false;
+	if( was_activated ) {
+		end_dimming();
+		state = 0;
+		write_state( 0 );
+	}
+	release_dimmer_channels();
+
+	// the queue of task_gled_isr must not keep a request of a destroyed LED:
+	while( isr_requests > 0 ) {
+		if( ! isr_task_started.exchange( true ) )   // the pended start has failed.
+			start_isr_task( nullptr, 0 );
+		vTaskDelay( 1 );
 	}
-	flash_task_handle = nullptr;
-	off();
-	activated = false;   // This will also terminate the flash thread if running.
 }
 
 void GLed::set_logic_mode( gled_switching_logic_t logic )
@@ -78,25 +191,57 @@ void GLed::set_logic_mode( bool a_on_is_high_level )
 void GLed::on()
 {
     if( activated ) {
+        end_dimming();
         state = 1;
-        digitalWrite(pin, on_is_high_level ? HIGH : LOW);
+        write_state( 1 );
     }
 }
 
 void GLed::off()
 {
     if( activated ) {
+        end_dimming();
         state = 0;
-        digitalWrite(pin, on_is_high_level ? LOW : HIGH);
+        write_state( 0 );
     }
 }
 
 void GLed::toggle()
 {
-    if( is_on() )
-        off();
-    else
-        on();
+    if( activated ) {
+        end_dimming();
+        write_state( state.fetch_xor( 1 ) ^ 1 );
+    }
+}
+
+void GLed::refresh()
+{
+	if( activated && ! dimmer_attached )
+		write_state( state, true );
+}
+
+uint32_t GLed::get_elided_writes()
+{
+	return GLedGpioCache::get_elided();
+}
+
+void GLed::write_state( int s, bool force )
+{
+	// another task may change the state while the pin is written.
+	// Each writer checks the state after its write and corrects the pin,
+	// so the last writer leaves pin and state consistent without a lock.
+	// The correction is forced, the cache may hold the level of the other writer.
+	for(;;) {
+		if( backend != nullptr )   // the backend skips unchanged levels itself.
+			backend->write( pin, gpio_level( s ) );
+		else if( GLedGpioCache::update( pin, gpio_level( s ), force ) )
+			digitalWrite( pin, gpio_level( s ) ? HIGH : LOW );
+		const int current = state;
+		if( current == s )
+			return;
+		s = current;
+		force = true;
+	}
 }
 
 void GLed::flash( unsigned count, unsigned dt_on, unsigned dt_off )
@@ -122,93 +267,823 @@ void GLed::flash( unsigned count, unsigned dt_on, unsigned dt_off )
 
 void GLed::async_flash_set_time_regime( unsigned dt_on, unsigned dt_off )
 {
-	ESP_LOGI( TAG, "async_flash_set_time_regime: old on=%u off=%u ms", flash_dt_on,  flash_dt_off );
-    flash_dt_on = dt_on;
-	flash_dt_off = dt_off == 0 ? dt_on : dt_off;
-	ESP_LOGI( TAG, "                             new on=%u off=%u ms", flash_dt_on,  flash_dt_off );
+	if( dt_off == 0 )
+		dt_off = dt_on;
+	ESP_LOGI( TAG, "async_flash_set_time_regime: old on=%u off=%u ms", flash_dt_on.load(), flash_dt_off.load() );
+	flash_dt_on = dt_on;
+	flash_dt_off = dt_off;
+
+	// a running base layer continues in phase with the new pattern, async_flash() makes its own:
+	const GLedPattern * current = layers[0].pattern;
+	if( current != nullptr ) {
+		GLedPattern * p = claim_pattern();
+		if( p != nullptr ) {   // otherwise overtaken by another writer.
+			p->set_flash( dt_on, dt_off );
+			layers[0].pattern.compare_exchange_strong( current, p );
+			release_pattern( p );
+		}
+	}
+	ESP_LOGI( TAG, "                             new on=%u off=%u ms", dt_on, dt_off );
+}
+
+// claim a pattern buffer for a writer of the base layer, one which is neither played,
+// nor read by the flash task, nor filled by another writer. Returns nullptr if all are in use.
+GLedPattern * GLed::claim_pattern()
+{
+	for( unsigned i = 0; i < GLED_PATTERN_BUFFERS; i++ ) {
+		const uint8_t bit = 1u << i;
+
+		if( pattern_claims.fetch_or( bit ) & bit )
+			continue;
+		// only the owner of the claim puts the buffer into the layer,
+		// so the buffer stays free once checked, see protect_pattern():
+		if( layers[0].pattern != &patterns[i] && pattern_hazard != &patterns[i] )
+			return &patterns[i];
+		pattern_claims.fetch_and( (uint8_t) ~bit );
+	}
+	return nullptr;
+}
+
+void GLed::release_pattern( const GLedPattern * p )
+{
+	pattern_claims.fetch_and( (uint8_t) ~(1u << (p - patterns)) );
+}
+
+// get the pattern of the base layer for the flash task and protect it against the writers
+// until the hazard is cleared: a writer which checked the hazard before sees the layer changed.
+const GLedPattern * GLed::protect_pattern()
+{
+	const GLedPattern * p = layers[0].pattern;
+
+	for(;;) {
+		pattern_hazard = p;
+		const GLedPattern * current = layers[0].pattern;
+		if( current == p )
+			return p;
+		p = current;
+	}
+}
+
+bool GLed::play_flash( uint64_t count, unsigned dt_on, unsigned dt_off, bool restart, TickType_t start )
+{
+	GLedPattern * p = claim_pattern();
+
+	if( dt_off == 0 )
+		dt_off = dt_on;
+	flash_dt_on = dt_on;
+	flash_dt_off = dt_off;
+	if( p == nullptr ) {
+		ESP_LOGW( TAG, "LED (%d) async_flash overtaken by another task", pin );
+		return false;
+	}
+	p->set_flash( dt_on, dt_off );
+	start_layer( 0, *p, count, restart, start );
+	release_pattern( p );
+	return true;
 }
 
 int GLed::async_flash( uint64_t count, unsigned dt_on, unsigned dt_off, int core_num )
 {
 	// run time: for count >=1: (2*count-1)*dt  [ms].
 
-	// NOTE: changing the blinking parameters is still in development.
-	//       The current implementation may be critical and needs a redesign due to a thread race condition.
-	
-    int rc = 0;
-    static task_args_t task_args;
-
-	if( flash_task_handle != nullptr )    // thread running, observe the RACE CONDITION 
-    { 
-    	// reset running thread parameters:
-		ESP_LOGI( TAG, "task_flash already running remaining: flash_count=%" PRIu64 ", flash_dt=(%u,%u)", flash_count, flash_dt_on,  flash_dt_off );
-		// set the new parameters:
-		flash_count = count;
-		async_flash_set_time_regime( dt_on, dt_off );
-		ESP_LOGI( TAG, "reset with new param's: flash_count=%" PRIu64 ", flash_dt=(%u,%u), core=%x, led activated=%d", flash_count, flash_dt_on, flash_dt_off, core_num, activated );
-    }
+	if( layers[0].pattern != nullptr )    // base layer running
+		ESP_LOGI( TAG, "task_flash already running remaining: flash_count=%" PRIu64 ", flash_dt=(%u,%u)", remaining_flashes(), flash_dt_on.load(), flash_dt_off.load() );
 	else
-	{
-		// start a flash thread:
-		ESP_LOGI( TAG, "async_flash: start a flash thread: flash_count=%" PRIu64 ", flash_dt=(%u,%u), core=%x, led activated=%d", flash_count, flash_dt_on, flash_dt_off, core_num, activated );
-
-    	flash_count = count;
-    	async_flash_set_time_regime( dt_on, dt_off );
-
-    	if( activated )
-    	{
-    		task_args.pGLed = this;
-
-			rc = xTaskCreatePinnedToCore(
-					task_flash
-					,  "task_flash"
-					,  2048
-					,  & task_args
-					,  2
-					,  & flash_task_handle
-					,  core_num
-			);
+		ESP_LOGI( TAG, "async_flash: start a flash thread: flash_count=%" PRIu64 ", flash_dt=(%u,%u), core=%x, led activated=%d", count, dt_on, dt_off, core_num, (int) activated );
+
+	// a running sequence continues in phase with the new parameters:
+	if( ! play_flash( count, dt_on, dt_off, false, xTaskGetTickCount() ) )
+		return 0;
+	return start_flash_task( core_num );
+}
+
+int GLed::async_morse( const char *text, unsigned unit_ms, uint64_t count, int core_num )
+{
+	GLedPattern * p = claim_pattern();
+
+	if( p == nullptr )   // overtaken by another writer.
+		return 0;
+	const unsigned n = p->compile_morse( text, unit_ms );
+	ESP_LOGI( TAG, "async_morse: \"%s\" %u chars compiled, %u steps, period=%u ms", text, n, p->size(), p->period() );
+	start_layer( 0, *p, count, true, xTaskGetTickCount() );
+	release_pattern( p );
+	return start_flash_task( core_num );
+}
+
+int GLed::async_morse( unsigned code, unsigned unit_ms, uint64_t count, int core_num )
+{
+	GLedPattern * p = claim_pattern();
+
+	if( p == nullptr )   // overtaken by another writer.
+		return 0;
+	p->compile_morse( code, unit_ms );
+	ESP_LOGI( TAG, "async_morse: code %u, %u steps, period=%u ms", code, p->size(), p->period() );
+	start_layer( 0, *p, count, true, xTaskGetTickCount() );
+	release_pattern( p );
+	return start_flash_task( core_num );
+}
+
+int GLed::async_overlay( unsigned priority, const GLedPattern & a_pattern, uint64_t count, int core_num )
+{
+	if( priority < 1 || priority > MAX_OVERLAY )
+		return -1;
+
+	ESP_LOGI( TAG, "async_overlay: LED (%d) priority=%u, count=%" PRIu64 ", period=%u ms", pin, priority, count, a_pattern.period() );
+	start_layer( priority, a_pattern, count, true, xTaskGetTickCount() );
+	return start_flash_task( core_num );
+}
+
+void GLed::cancel_overlay( unsigned priority )
+{
+	if( priority >= 1 && priority <= MAX_OVERLAY ) {
+		layers[priority].pattern = nullptr;
+		wake_flash_task();
+	}
+}
+
+void IRAM_ATTR GLed::start_layer( unsigned layer, const GLedPattern & a_pattern, uint64_t count, bool restart, TickType_t now )
+{
+	gled_layer_t & l = layers[layer];
+
+	if( count == 0 || a_pattern.size() == 0 ) {
+		l.pattern = nullptr;
+		return;
+	}
+
+	// the cursor is owned by the flash task, a restart is only requested:
+	l.count = count >= LAYER_FOR_EVER ? LAYER_FOR_EVER : (uint32_t) count;
+	if( restart || l.pattern == nullptr ) {
+		l.start = now;
+		l.restart = true;
+	}
+	l.pattern = &a_pattern;
+}
+
+void GLed::stop_layers()
+{
+	for( unsigned i = 0; i < GLED_LAYERS; i++ )
+		layers[i].pattern = nullptr;
+}
+
+bool GLed::is_flashing() const
+{
+	for( unsigned i = 0; i < GLED_LAYERS; i++ )
+		if( layers[i].pattern != nullptr )
+			return true;
+	return activity_enabled;
+}
+
+bool GLed::next_edge_time( TickType_t & tick ) const
+{
+	if( ! next_edge_valid )
+		return false;
+	tick = next_edge;
+	return true;
+}
+
+int GLed::start_flash_task( int core_num )
+{
+	if( done_group != nullptr )
+		xEventGroupClearBits( done_group, done_bits );
+
+	// the compare and swap makes sure that only one caller creates the task.
+	// It terminates when all patterns have expired, see task_flash:
+	bool running = false;
+	if( ! flash_task_running.compare_exchange_strong( running, true ) ) {
+		wake_flash_task();   // the running task picks up the new layers at once.
+		return 0;
+	}
+	if( ! activated ) {
+		flash_task_running = false;
+		return 0;
+	}
+
+	init_pm_locks();
+	flash_task_count++;
+	const int rc = xTaskCreatePinnedToCore(
+			task_flash
+			,  "task_flash"
+			,  2048
+			,  this
+			,  2
+			,  nullptr     // the task publishes its handle itself.
+			,  core_num
+	);
+	if( rc != pdPASS ) {
+		flash_task_count--;
+		flash_task_running = false;
+	}
+	return rc;
+}
+
+void GLed::wake_flash_task()
+{
+	// the terminating task waits for the wakers before it gets deleted, see task_flash:
+	flash_task_wakers++;
+	const TaskHandle_t handle = flash_task_handle;
+
+	// a task not yet started evaluates the layers anyway:
+	if( handle != nullptr )
+		xTaskNotifyGive( handle );
+	flash_task_wakers--;
+}
+
+void GLed::stop_flash_task()
+{
+	// each round terminates the task running then, also one started meanwhile by another task:
+	while( flash_task_count > 0 ) {
+		flash_task_generation++;
+		// called by the task itself (done callback), it terminates after the callback:
+		if( xTaskGetCurrentTaskHandle() == flash_task_handle )
+			return;
+		wake_flash_task();
+		vTaskDelay( 1 );
+	}
+}
+
+// advance the cursor of a layer to the given time.
+// Returns false if the layer is not active or its count has expired.
+bool GLed::advance_layer( gled_layer_t & l, const GLedPattern * p, TickType_t now )
+{
+	if( p == nullptr )
+		return false;
+
+	if( l.restart.exchange( false ) ) {
+		l.step = 0;
+		l.step_end = l.start + p->duration( 0 ) / portTICK_PERIOD_MS;
+	}
+
+	TickType_t period = 0;
+	for( unsigned i = 0; i < p->size(); i++ )
+		period += p->duration( i ) / portTICK_PERIOD_MS;
+	if( period == 0 ) {
+		l.pattern.compare_exchange_strong( p, nullptr );
+		return false;
+	}
+
+	// a layer hidden by an overlay for a long time skips the complete periods at once:
+	if( (int32_t)(now - l.step_end) > (int32_t) period ) {
+		const uint32_t n = (now - l.step_end) / period;
+		uint32_t c = l.count;
+		if( c != LAYER_FOR_EVER ) {
+			if( c <= n ) {
+				expire_layer( l, p, c );
+				return false;
+			}
+			l.count.compare_exchange_strong( c, c - n );
+		}
+		l.step_end += n * period;
+	}
+
+	while( (int32_t)(now - l.step_end) >= 0 ) {
+		if( ++l.step >= p->size() ) {
+			l.step = 0;
+			// inform the GLed object about the remaining count, an endless count is never decreased.
+			// A count set meanwhile by the application is not overwritten:
+			uint32_t c = l.count;
+			if( c != LAYER_FOR_EVER ) {
+				if( c <= 1 ) {
+					expire_layer( l, p, c );
+					return false;
+				}
+				l.count.compare_exchange_strong( c, c - 1 );
+			}
 		}
+		l.step_end += p->duration( l.step ) / portTICK_PERIOD_MS;
 	}
+	// only the last step is stretched to the grid, the next period starts aligned:
+	if( l.step + 1 == p->size() )
+		l.step_end = align_wake( l.step_end );
+	return true;
+}
 
-    return rc;
+// end a layer whose count has expired, unless the application has restarted it meanwhile.
+void GLed::expire_layer( gled_layer_t & l, const GLedPattern * p, uint32_t c )
+{
+	if( l.count.compare_exchange_strong( c, 0 ) && ! l.restart )
+		l.pattern.compare_exchange_strong( p, nullptr );
 }
 
 void task_flash( void *pvParameters ){
-	GLed * pGLed = ((task_args_t*)(pvParameters)) -> pGLed;
+	GLed * pGLed = (GLed*) pvParameters;
+	const uint32_t generation = pGLed->flash_task_generation;   // changed by stop_flash_task().
+	bool flashing = false;            // any layer or the activity light is active.
+	bool start_lightening = false;    // LED state before the patterns started.
 
+	pGLed->flash_task_handle = xTaskGetCurrentTaskHandle();
 	ESP_LOGI( TAG, "task_flash started (#=%" PRIu64 ", dt=(%u,%u) activated=%d)", 
-					pGLed -> flash_count, pGLed -> flash_dt_on, pGLed -> flash_dt_off, (int) pGLed->activated );
-
-	const bool start_lightening = pGLed->is_on();
-
-	// terminate the thread if the LED gets de-activated or the counter countdown reaches 0:
-    while( pGLed -> flash_count && pGLed->activated  ) {
-    	pGLed->on();
-		vTaskDelay( pGLed -> flash_dt_on / portTICK_PERIOD_MS  );
-        pGLed->off();
-        vTaskDelay( pGLed -> flash_dt_off / portTICK_PERIOD_MS );
-        // just be sure: no overflow: never go from count = 0 to count = -1 == =xFFFF...FFFFF
-        if( pGLed -> flash_count > 0 )
-        {
-        	const uint64_t c = pGLed -> flash_count - 1;
-        	pGLed -> flash_count = c; // inform the GLed object about the remaining pulse count.
-        }
-    }
+					pGLed -> remaining_flashes(), pGLed -> flash_dt_on.load(), pGLed -> flash_dt_off.load(), (int) pGLed->activated );
+
+	// terminate the thread if the LED gets de-activated, end() is called or all patterns have expired:
+	for(;;) {
+		while( pGLed->activated && pGLed->flash_task_generation == generation ) {
+			GLED_PM_ACQUIRE( pm_edge_lock );
+			const TickType_t now = xTaskGetTickCount();
+			int top = -1;
+
+			// all layers are advanced, so the hidden ones stay in phase.
+			// The overlay patterns belong to the application, the base layer ones are protected:
+			for( int i = 0; i < GLED_LAYERS; i++ ) {
+				const GLedPattern * p = i == 0 ? pGLed->protect_pattern() : pGLed->layers[i].pattern.load();
+				if( GLed::advance_layer( pGLed->layers[i], p, now ) )
+					top = i;
+			}
+			pGLed->pattern_hazard = nullptr;
+			bool lightening = false;
+			TickType_t wake = now;
+			if( top >= 0 ) {
+				lightening = GLedPattern::level( pGLed->layers[top].step );
+				wake = pGLed->layers[top].step_end;
+			}
+
+			// the activity light is below all layers:
+			if( pGLed->activity_enabled ) {
+				const TickType_t activity_wake = pGLed->advance_activity( now );
+				if( top < 0 ) {
+					lightening = pGLed->activity_on;
+					wake = activity_wake;
+				}
+				else if( (int32_t)(activity_wake - wake) < 0 )
+					wake = activity_wake;
+			}
+			else if( top < 0 ) {
+				if( flashing ) {
+					// all patterns have expired:
+					flashing = false;
+					pGLed->switch_lightening( start_lightening );
+					pGLed->next_edge_valid = false;
+
+					// inform the application:
+					if( pGLed->done_group != nullptr )
+						xEventGroupSetBits( pGLed->done_group, pGLed->done_bits );
+					if( pGLed->done_callback != nullptr )
+						pGLed->done_callback( *pGLed, pGLed->done_arg );
+				}
+				// nothing left to play:
+				GLED_PM_RELEASE( pm_edge_lock );
+				break;
+			}
+
+			if( ! flashing ) {
+				flashing = true;
+				start_lightening = pGLed->is_on();
+			}
+			pGLed->switch_lightening( lightening );
+			pGLed->next_edge = wake;
+			pGLed->next_edge_valid = true;
+			// sleep until the next edge, a changed layer wakes the task up earlier:
+			GLED_PM_RELEASE( pm_edge_lock );
+			ulTaskNotifyTake( pdTRUE, wake - now );
+		}
 
-    ESP_LOGW( TAG, "task_flash terminating (#=%" PRIu64 ", activated=%d)", 
-    				pGLed -> flash_count, (int) pGLed->activated );
-    pGLed->switch_lightening( start_lightening );
-    pGLed -> flash_task_handle = nullptr;
+		pGLed->next_edge_valid = false;
+		pGLed->flash_task_running = false;   // from now on a new task may be started.
+		// a pattern started meanwhile may have found the task still running and only woken it up:
+		bool running = false;
+		if( ! pGLed->activated || pGLed->flash_task_generation != generation || ! pGLed->is_flashing()
+				|| ! pGLed->flash_task_running.compare_exchange_strong( running, true ) )
+			break;
+	}
+
+	ESP_LOGW( TAG, "task_flash terminating (#=%" PRIu64 ", activated=%d)", 
+					pGLed -> remaining_flashes(), (int) pGLed->activated );
+	// the wakers which still use the handle finish before the task gets deleted:
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	pGLed->flash_task_handle.compare_exchange_strong( self, nullptr );
+	while( pGLed->flash_task_wakers > 0 )
+		vTaskDelay( 1 );
+	pGLed->flash_task_count--;   // the last access, the GLed may be destroyed from now on.
 	vTaskDelete(NULL);
 }
 
+int GLed::activity_mode( unsigned dt_on_min, unsigned dt_off_min, int core_num )
+{
+	activity_dt_on = dt_on_min / portTICK_PERIOD_MS > 0 ? dt_on_min / portTICK_PERIOD_MS : 1;
+	activity_dt_off = dt_off_min / portTICK_PERIOD_MS > 0 ? dt_off_min / portTICK_PERIOD_MS : 1;
+
+	if( ! activity_enabled ) {
+		ESP_LOGI( TAG, "LED (%d) activity mode: on>=%u ms, off>=%u ms", pin, dt_on_min, dt_off_min );
+		activity_pending.store( 0, std::memory_order_relaxed );
+		activity_on = false;
+		activity_until = xTaskGetTickCount();
+		activity_enabled = true;
+	}
+	return start_flash_task( core_num );
+}
+
+void GLed::stop_activity_mode()
+{
+	activity_enabled = false;
+	wake_flash_task();
+}
+
+TickType_t GLed::advance_activity( TickType_t now )
+{
+	if( (int32_t)(now - activity_until) >= 0 ) {
+		// the flag is cleared when it is read, so an event in between is not lost:
+		const bool triggered = activity_pending.exchange( 0, std::memory_order_acquire ) != 0;
+
+		if( triggered ) {
+			// a new pulse, or an extension of the current one (retrigger):
+			activity_on = true;
+			activity_until = now + activity_dt_on;
+		}
+		else if( activity_on ) {
+			// the pulse ends, keep the minimal gap before the next one:
+			activity_on = false;
+			activity_until = now + activity_dt_off;
+		}
+		else {
+			// idle: sample the flag again after the minimal gap.
+			activity_until = now + activity_dt_off;
+		}
+	}
+	return activity_until;
+}
+
+// ---------------------------------------------------------------------------
+// interrupt service routine interface: only registers and the layers are touched,
+// everything else is passed to task_gled_isr.
+
+void IRAM_ATTR GLed::on_from_isr()
+{
+	if( activated && ! dimmer_attached ) {
+		state = 1;
+		write_state_from_isr( 1 );
+	}
+}
+
+void IRAM_ATTR GLed::off_from_isr()
+{
+	if( activated && ! dimmer_attached ) {
+		state = 0;
+		write_state_from_isr( 0 );
+	}
+}
+
+void IRAM_ATTR GLed::toggle_from_isr()
+{
+	if( activated && ! dimmer_attached )
+		write_state_from_isr( state.fetch_xor( 1 ) ^ 1 );
+}
+
+void IRAM_ATTR GLed::write_state_from_isr( int s )
+{
+	// see write_state(), the other core may change the state meanwhile.
+	bool force = false;
+	for(;;) {
+		if( backend != nullptr )
+			backend->write_from_isr( pin, gpio_level( s ) );
+		else if( GLedGpioCache::update( pin, gpio_level( s ), force ) )
+			gled_gpio_write( pin, gpio_level( s ) );
+		const int current = state;
+		if( current == s )
+			return;
+		s = current;
+		force = true;
+	}
+}
+
+bool IRAM_ATTR GLed::async_overlay_from_isr( unsigned priority, const GLedPattern & a_pattern, uint64_t count, BaseType_t *task_woken )
+{
+	if( priority < 1 || priority > MAX_OVERLAY || ! activated )
+		return false;
+
+	start_layer( priority, a_pattern, count, true, xTaskGetTickCountFromISR() );
+
+	if( flash_task_running ) {
+		// see wake_flash_task():
+		flash_task_wakers++;
+		const TaskHandle_t handle = flash_task_handle;
+		if( handle != nullptr )
+			vTaskNotifyGiveFromISR( handle, task_woken );
+		flash_task_wakers--;
+		return true;
+	}
+
+	// a task can not be created in an ISR:
+	return queue_isr_request( REQUEST_FLASH, task_woken );
+}
+
+bool IRAM_ATTR GLed::queue_isr_request( uint8_t request, BaseType_t *task_woken )
+{
+	const isr_request_t r = { this, request };
+
+	// counted before the send, so end() can not miss a request being queued:
+	isr_requests++;
+	if( isr_queue == nullptr || xQueueSendFromISR( isr_queue, &r, task_woken ) != pdTRUE ) {
+		isr_requests--;
+		isr_requests_lost++;
+		return false;
+	}
+
+	// the first request starts task_gled_isr, a task can not be created in an ISR:
+	if( ! isr_task_started.exchange( true ) && xTimerPendFunctionCallFromISR( start_isr_task, nullptr, 0, task_woken ) != pdPASS )
+		isr_task_started = false;
+	return true;
+}
+
+void task_gled_isr( void * )
+{
+	isr_request_t request;
+
+	for(;;) {
+		if( xQueueReceive( isr_queue, &request, portMAX_DELAY ) != pdTRUE )
+			continue;
+
+		const uint32_t lost = isr_requests_lost.exchange( 0 );
+		if( lost > 0 )
+			ESP_LOGW( TAG, "task_gled_isr: %u requests lost, the queue was full", (unsigned) lost );
+
+		GLed * pGLed = request.pGLed;
+
+		switch( request.request ) {
+		case REQUEST_FLASH:
+			pGLed->start_flash_task( FLASH_TASK_CORE );
+			break;
+
+		case REQUEST_FADE_END:
+			if( ! pGLed->breathing )   // a late fade end event of a stopped LED.
+				break;
+			pGLed->fade_up = ! pGLed->fade_up;
+			ledc_set_fade_with_time( GLED_LEDC_SPEED_MODE, (ledc_channel_t) pGLed->ledc_channel,
+									 pGLed->fade_up ? pGLed->breathe_max : pGLed->breathe_min,
+									 pGLed->breathe_dt );
+			ledc_fade_start( GLED_LEDC_SPEED_MODE, (ledc_channel_t) pGLed->ledc_channel, LEDC_FADE_NO_WAIT );
+			break;
+		}
+		pGLed->isr_requests--;   // the last access, end() may return from now on.
+	}
+}
+
+// ---------------------------------------------------------------------------
+// breathing: the LEDC hardware fades, the fade end interrupt requests the next fade.
+// The LEDC fade functions take a mutex and must not be called in an ISR,
+// so the ISR only queues the LED and task_gled_isr starts the opposite fade.
+
+bool IRAM_ATTR on_fade_end( const ledc_cb_param_t *param, void *user_arg )
+{
+	BaseType_t task_woken = pdFALSE;
+
+	// a lost request stops the breathing, task_gled_isr logs it:
+	if( param->event == LEDC_FADE_END_EVT )
+		((GLed*) user_arg)->queue_isr_request( REQUEST_FADE_END, &task_woken );
+	return task_woken == pdTRUE;
+}
+
+esp_err_t GLed::breathe( unsigned period_ms, uint8_t min, uint8_t max )
+{
+	esp_err_t rc;
+
+	if( ! activated )
+		return ESP_ERR_INVALID_STATE;
+
+	if( backend != nullptr ) {   // the device fades by itself.
+		stop_flash_task();
+		stop_layers();
+		activity_enabled = false;
+		if( (rc = backend->breathe( pin, period_ms, output_duty( min ), output_duty( max ) )) != ESP_OK )
+			return rc;
+		state = 1;
+		breathing = true;
+		return ESP_OK;
+	}
+
+	breathe_dt = period_ms / 2 > 0 ? period_ms / 2 : 1;
+	breathe_min = min;
+	breathe_max = max;
+
+	if( breathing )   // the next fade uses the new values.
+		return ESP_OK;
+
+	stop_flash_task();
+	stop_layers();
+	activity_enabled = false;
+	detach_dimmer();   // a steady set_brightness() channel gets configured again.
+
+	if( (rc = attach_ledc( breathe_min )) != ESP_OK )
+		return rc;
+
+	ESP_LOGI( TAG, "LED (%d) breathing: channel=%d period=%u ms, brightness=(%u,%u)", pin, ledc_channel, period_ms, min, max );
+
+	state = 1;
+	fade_up = true;
+	breathing = true;
+	ledc_set_fade_with_time( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, breathe_max, breathe_dt );
+	return ledc_fade_start( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, LEDC_FADE_NO_WAIT );
+}
+
+esp_err_t GLed::set_brightness( uint8_t level )
+{
+	esp_err_t rc;
+
+	if( ! activated )
+		return ESP_ERR_INVALID_STATE;
+
+	stop_flash_task();
+	stop_layers();
+	activity_enabled = false;
+
+	if( backend != nullptr ) {
+		breathing = false;
+		state = level > 0 ? 1 : 0;
+		return backend->set_brightness( pin, output_duty( level ) );
+	}
+
+	if( breathing )
+		detach_dimmer();
+
+	if( dimmer == DIMMER_SIGMA_DELTA )
+		rc = attach_sdm( level );
+	else if( dimmer_attached ) {
+		ledc_set_duty( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, level );
+		rc = ledc_update_duty( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel );
+	}
+	else
+		rc = attach_ledc( level );
+
+	state = level > 0 ? 1 : 0;
+	return rc;
+}
+
+esp_err_t GLed::attach_ledc( uint32_t duty )
+{
+	esp_err_t rc;
+
+	if( ! ledc_ready ) {
+		ledc_timer_config_t timer_conf = {};
+		timer_conf.speed_mode      = GLED_LEDC_SPEED_MODE;
+		timer_conf.duty_resolution = LEDC_TIMER_8_BIT;
+		timer_conf.timer_num       = GLED_LEDC_TIMER;
+		timer_conf.freq_hz         = GLED_LEDC_FREQUENCY;
+		timer_conf.clk_cfg         = LEDC_AUTO_CLK;
+		if( (rc = ledc_timer_config( &timer_conf )) != ESP_OK )
+			return rc;
+		if( (rc = ledc_fade_func_install( 0 )) != ESP_OK )
+			return rc;
+		ledc_ready = true;
+	}
+
+	if( ledc_channel < 0 ) {
+		for( int ch = LEDC_CHANNEL_MAX - 1; ch >= 0; ch-- ) {
+			if( (ledc_channels_used & (1u << ch)) == 0 ) {
+				ledc_channels_used |= 1u << ch;
+				ledc_channel = ch;
+				break;
+			}
+		}
+		if( ledc_channel < 0 ) {
+			ESP_LOGE( TAG, "LED (%d): no free LEDC channel", pin );
+			return ESP_ERR_NOT_FOUND;
+		}
+	}
+
+	ledc_channel_config_t channel_conf = {};
+	channel_conf.gpio_num   = pin;
+	channel_conf.speed_mode = GLED_LEDC_SPEED_MODE;
+	channel_conf.channel    = (ledc_channel_t) ledc_channel;
+	channel_conf.intr_type  = LEDC_INTR_DISABLE;
+	channel_conf.timer_sel  = GLED_LEDC_TIMER;
+	channel_conf.duty       = duty;
+	channel_conf.hpoint     = 0;
+	channel_conf.flags.output_invert = on_is_high_level ? 0 : 1;
+	if( (rc = ledc_channel_config( &channel_conf )) != ESP_OK )
+		return rc;
+
+	ledc_cbs_t callbacks = {};
+	callbacks.fade_cb = on_fade_end;
+	if( (rc = ledc_cb_register( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, &callbacks, this )) != ESP_OK )
+		return rc;
+
+	init_pm_locks();
+	GLED_PM_ACQUIRE( pm_ledc_lock );   // the LEDC clock stops in light sleep.
+	dimmer_attached = true;
+	return ESP_OK;
+}
+
+esp_err_t GLed::attach_sdm( uint8_t level )
+{
+#if GLED_SDM_CHANNELS > 0
+	esp_err_t rc;
+	const int8_t density = (int) output_duty( level ) - 128;
+
+	if( sdm_channel < 0 ) {
+		for( int ch = 0; ch < GLED_SDM_CHANNELS; ch++ ) {
+			if( (sdm_channels_used & (1u << ch)) == 0 ) {
+				sdm_channels_used |= 1u << ch;
+				sdm_channel = ch;
+				break;
+			}
+		}
+		if( sdm_channel < 0 ) {
+			ESP_LOGE( TAG, "LED (%d): no free sigma-delta channel", pin );
+			return ESP_ERR_NOT_FOUND;
+		}
+	}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	if( ! dimmer_attached ) {
+		sdm_config_t config = {};
+		config.gpio_num       = pin;
+		config.clk_src        = SDM_CLK_SRC_DEFAULT;
+		config.sample_rate_hz = GLED_SDM_SAMPLE_RATE;
+		if( (rc = sdm_new_channel( &config, &sdm_handles[sdm_channel] )) != ESP_OK )
+			return rc;
+		if( (rc = sdm_channel_enable( sdm_handles[sdm_channel] )) != ESP_OK ) {
+			sdm_del_channel( sdm_handles[sdm_channel] );
+			sdm_handles[sdm_channel] = nullptr;
+			return rc;
+		}
+	}
+	if( (rc = sdm_channel_set_pulse_density( sdm_handles[sdm_channel], density )) != ESP_OK )
+		return rc;
+#else
+	if( ! dimmer_attached ) {
+		sigmadelta_config_t config = {};
+		config.channel            = (sigmadelta_channel_t) sdm_channel;
+		config.sigmadelta_duty    = density;
+		config.sigmadelta_prescale = APB_CLK_FREQ / GLED_SDM_SAMPLE_RATE - 1;
+		config.sigmadelta_gpio    = pin;
+		if( (rc = sigmadelta_config( &config )) != ESP_OK )
+			return rc;
+	}
+	else if( (rc = sigmadelta_set_duty( (sigmadelta_channel_t) sdm_channel, density )) != ESP_OK )
+		return rc;
+#endif
+
+	if( ! dimmer_attached ) {
+		ESP_LOGI( TAG, "LED (%d) dimmed by sigma-delta channel %d", pin, sdm_channel );
+		init_pm_locks();
+		GLED_PM_ACQUIRE( pm_ledc_lock );   // the sigma-delta clock stops in light sleep as well.
+		dimmer_attached = true;
+	}
+	return ESP_OK;
+#else
+	(void) level;
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void GLed::set_dimmer( gled_dimmer_t a_dimmer )
+{
+	if( a_dimmer == dimmer )
+		return;
+	// detach_dimmer() has to know the peripheral which drives the pin:
+	if( dimmer_attached && ! breathing ) {
+		detach_dimmer();
+		write_state( state, true );
+	}
+	dimmer = a_dimmer;
+}
+
+void GLed::detach_dimmer()
+{
+	// breathe() always uses the LEDC, set_brightness() the selected dimmer.
+	const bool by_sdm = ! breathing && dimmer == DIMMER_SIGMA_DELTA;
+
+	// only one caller restores the pin:
+	if( ! dimmer_attached.exchange( false ) )
+		return;
+	GLED_PM_RELEASE( pm_ledc_lock );
+	if( by_sdm ) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && GLED_SDM_CHANNELS > 0
+		sdm_channel_disable( sdm_handles[sdm_channel] );
+		sdm_del_channel( sdm_handles[sdm_channel] );
+		sdm_handles[sdm_channel] = nullptr;
+#endif
+		pinMode( pin, OUTPUT );   // route the gpio back from the sigma-delta modulator.
+		return;
+	}
+	breathing = false;   // task_gled_isr ignores the pending fade end event.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	ledc_fade_stop( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel );
+#endif
+	ledc_cbs_t callbacks = {};   // no more fade end events of this LED.
+	ledc_cb_register( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, &callbacks, nullptr );
+	ledc_stop( GLED_LEDC_SPEED_MODE, (ledc_channel_t) ledc_channel, on_is_high_level ? 0 : 1 );
+	pinMode( pin, OUTPUT );   // route the gpio back from the LEDC to the plain output.
+}
+
+void GLed::release_dimmer_channels()
+{
+	if( ledc_channel >= 0 ) {
+		ledc_channels_used &= ~(1u << ledc_channel);
+		ledc_channel = -1;
+	}
+	if( sdm_channel >= 0 ) {
+		sdm_channels_used &= ~(1u << sdm_channel);
+		sdm_channel = -1;
+	}
+}
+
 void GLed::reconnect_to_pin( int a_pin, gled_switching_logic_t logic )
 {
 	end();
 
     state = 0;
     activated = 0;
+    if( backend == nullptr )
+        GLedGpioCache::forget( pin );
     set_logic_mode( logic );
     pin = a_pin;
 }
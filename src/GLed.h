@@ -23,6 +23,12 @@
 #define GLED_HEADER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <driver/ledc.h>
+#include <freertos/event_groups.h>
+
+#include "GLedBackend.h"
+#include "GLedPattern.h"
 
 // Here i follow the convention that GPIO 2 may control a build in LED.
 // But be aware this is only a guess, many boards use a different gpio to control the LED.
@@ -36,6 +42,35 @@
 #define FLASH_TASK_CORE tskNO_AFFINITY
 #endif
 
+// LEDC resources used by breathe(). The channels are taken from the top of the range,
+// so they do not collide with the Arduino ledcAttach() allocation, which starts at channel 0.
+#ifndef GLED_LEDC_SPEED_MODE
+#define GLED_LEDC_SPEED_MODE LEDC_LOW_SPEED_MODE
+#endif
+#ifndef GLED_LEDC_TIMER
+#define GLED_LEDC_TIMER LEDC_TIMER_3
+#endif
+#ifndef GLED_LEDC_FREQUENCY
+#define GLED_LEDC_FREQUENCY 5000
+#endif
+
+// sample rate of the sigma-delta dimmer (see set_dimmer()). 1 MHz keeps the pulses far above
+// any visible flicker and still lets the LED driver transistor switch cleanly.
+#ifndef GLED_SDM_SAMPLE_RATE
+#define GLED_SDM_SAMPLE_RATE 1000000
+#endif
+
+// number of pattern layers per LED: the base layer and the overlays on top of it.
+#ifndef GLED_LAYERS
+#define GLED_LAYERS 4
+#endif
+
+// pattern buffers of the base layer per LED: the one played, the one the flash task may still read
+// and one for a writer. Each further buffer lets one more writer fill it at the same time.
+#ifndef GLED_PATTERN_BUFFERS
+#define GLED_PATTERN_BUFFERS 3
+#endif
+
 /**
  * The GLed class models an LED. It provides methods to manipulate the LED
  * and switch it on and off. This conceals the fact that the switching logic of the
@@ -46,17 +81,34 @@
  * To do this, a GLed object only needs to be told which pin is used and whether
  * the switching logic is positive (HIGH) or negative (GND) when it is created.
  * \n
- * This class is not thread save.
+ * The asynchronous patterns are organized in layers. async_flash() and async_morse()
+ * drive the base layer, async_overlay() puts a pattern with a higher priority on top of it,
+ * for example to signal an error over a heartbeat. The highest active layer drives the LED.
+ * The layers below keep running in the dark, so they continue in phase when the overlay expires.
+ * \n
+ * The switching methods may be called from several tasks on both cores. The state is kept
+ * in atomic variables which are changed by atomic operations (compare and swap, exchange),
+ * no mutex is taken, so a toggle() never waits for a lock.
+ * A writer of the base layer (async_flash(), async_morse()) fills a pattern buffer of its own.
+ * If several tasks change the base layer at the same time the last one wins, a call which
+ * finds all buffers in use by other writers is overtaken by them and has no effect.
+ * The configuration (begin(), end(), set_logic_mode(), reconnect_to_pin()) is not thread save.
  */
 class GLed {
 public:
     enum gled_switching_logic_t { LOW_IS_ACTIVE, HIGH_IS_ACTIVE }; ///< switching logic selection type.
+    enum gled_dimmer_t { DIMMER_LEDC, DIMMER_SIGMA_DELTA };         ///< peripheral used by set_brightness().
+    typedef void (*gled_done_callback_t)( GLed & led, void *arg );  ///< called when the flash thread has finished.
 
     static const int MY_LED_BUILDIN = LED_BUILTIN;                 ///< setup for NodeMCU v3 / Wemos d1 mini board & Co.
     static const int   DEFAULT_FLASH_ON_TIME = 64;                 ///< default on time per flash [ms]
     static const int   DEFAULT_FLASH_OFF_TIME = 1000;              ///< default off time per flash [ms]
     static const int MAX_FLASH = 100;                              ///< syncron flash: truncate the number a flashes to this value.
-    static const uint64_t FLASH_FOR_EVER = (uint64_t)(~0);         ///< number of blink sequences to be made.
+    static const uint64_t FLASH_FOR_EVER = (uint64_t)(~0);         ///< endless sequence, counts from 2^32-1 on are endless as well.
+    static const int   DEFAULT_MORSE_UNIT = 150;                   ///< default duration of a morse dot [ms]
+    static const unsigned MAX_OVERLAY = GLED_LAYERS - 1;           ///< highest overlay priority, the base layer is 0.
+    static const int   DEFAULT_ACTIVITY_ON_TIME = 30;              ///< activity light: minimal visible on time [ms]
+    static const int   DEFAULT_ACTIVITY_OFF_TIME = 30;             ///< activity light: minimal gap between two pulses [ms]
 
     /**
      * the GLed standard constructor initializes the object
@@ -66,13 +118,8 @@ public:
      */
     GLed()
     	: pin(MY_LED_BUILDIN)
-    	, state(0)
-    	, activated(false)
+    	, backend(nullptr)
     	, on_is_high_level(false)
-    	, flash_count(0)
-		, flash_dt_on(0)
-		, flash_dt_off(0)
-		, flash_task_handle(nullptr)
     {};
 
     /**
@@ -84,14 +131,8 @@ public:
      */
     GLed(int a_pin )
         : pin(a_pin)
-        , state(0)
-        , activated(false)
+        , backend(nullptr)
         , on_is_high_level(true)
-    	, flash_count(0)
-		, flash_dt_on(0)
-		, flash_dt_off(0)
-		, flash_task_handle(nullptr)
-
     {};
 
     /**
@@ -104,17 +145,24 @@ public:
      */
     GLed(int a_pin, gled_switching_logic_t a_switch_logic )
         : pin(a_pin)
-        , state(0)
-        , activated(false)
+        , backend(nullptr)
         , on_is_high_level(a_switch_logic == HIGH_IS_ACTIVE)
-    	, flash_count(0)
-		, flash_dt_on(0)
-		, flash_dt_off(0)
-    	, flash_task_handle(nullptr)
     { 
 		set_logic_mode( a_switch_logic );
 	};
 
+    /**
+     * make a LED control object for a LED driven by an output of an external device.
+     * @param: a_backend: the driver of the device, see GLedShiftRegister.
+     * @param: channel: the output number of the device, used in place of the gpio number.
+     * @param: a_switch_logic: see above.
+     */
+    GLed(GLedBackend & a_backend, unsigned channel, gled_switching_logic_t a_switch_logic = HIGH_IS_ACTIVE )
+        : pin(channel)
+        , backend(&a_backend)
+        , on_is_high_level(a_switch_logic == HIGH_IS_ACTIVE)
+    {};
+
 	~GLed();
 
     /**
@@ -195,7 +243,50 @@ public:
     void toggle();
 
     /**
-     * get the pin used to control the LED of this object.
+     * write the current state to the gpio pin again.
+     * The switching methods skip the write if the pin has the level already,
+     * refresh() writes in any case, for ex. after another driver has changed the pin.
+     */
+    void refresh();
+
+    /**
+     * get the number of gpio writes skipped because the pin had the level already.
+     * The counter covers all LEDs.
+     */
+    static uint32_t get_elided_writes();
+
+    /**
+     * align the periods of all flash patterns to a common time grid.
+     * With automatic light sleep each edge wakes up the chip. The last step of each period
+     * is stretched by less than the grid, so the next period starts on the grid and the
+     * following edges of several LEDs with the same step times fall into the same wake up.
+     * The steps within a period keep their durations, the activity light is not aligned.
+     * @param ms: grid [ms], 0 switches the alignment off.
+     */
+    static void set_wake_alignment( unsigned ms ) { wake_alignment = ms / portTICK_PERIOD_MS; }
+
+    /**
+     * make the led lightening, to be called from an interrupt service routine.
+     * For a native gpio the *_from_isr() methods are placed in IRAM and write the gpio registers directly,
+     * so they work while the flash cache is disabled. A LED of a backend is written through the vtable
+     * in flash, see GLedBackend::write_from_isr(), it must not be switched while the cache is disabled.
+     * They have no effect on a breathing or dimmed LED.
+     * A running flash thread overrides the state with its next edge.
+     */
+    void IRAM_ATTR on_from_isr();
+
+    /**
+     * switch the led off, to be called from an interrupt service routine. See on_from_isr().
+     */
+    void IRAM_ATTR off_from_isr();
+
+    /**
+     * change the lightening state of the LED, to be called from an interrupt service routine. See on_from_isr().
+     */
+    void IRAM_ATTR toggle_from_isr();
+
+    /**
+     * get the pin used to control the LED of this object, the channel for a LED of a backend.
      * @parmas pin: pin number
      */
     int get_pin() const { return pin; }
@@ -243,6 +334,202 @@ public:
 	*/
     void async_flash_set_time_regime( unsigned dt_on, unsigned dt_off );
 
+    /** signal a text as morse code, none blocking like async_flash().
+     *  The text is compiled once into the flash pattern of the LED and played by the flash thread,
+     *  no memory is allocated per character. Letters, digits and blanks are signaled,
+     *  other characters are ignored. See GLedPattern::compile_morse() for the timing.
+     *  A running async_flash() or async_morse() sequence is replaced by the message.
+     *  A following async_flash() or async_flash_set_time_regime() call
+     *  switches back to the simple on/off flashing.
+     *  @param text: message to be signaled.
+     *  @param unit_ms: duration of a morse dot (ms).
+     *  @param count: number of times the message is repeated.
+     *  @param core_no: core to run the flash thread.
+     *  @return pdPASS or 0 on success, otherwise an error code of xTaskCreatePinnedToCore().
+     */
+    int async_morse( const char *text,
+    				 unsigned unit_ms = DEFAULT_MORSE_UNIT,
+    				 uint64_t count = FLASH_FOR_EVER,
+    				 int core = FLASH_TASK_CORE );
+
+    /** signal a number, e.g. an error code, as morse digits. Works like async_morse( text ).
+     *  @param code: number to be signaled.
+     *  @param unit_ms: duration of a morse dot (ms).
+     *  @param count: number of times the code is repeated.
+     *  @param core_no: core to run the flash thread.
+     *  @return pdPASS or 0 on success, otherwise an error code of xTaskCreatePinnedToCore().
+     */
+    int async_morse( unsigned code,
+    				 unsigned unit_ms = DEFAULT_MORSE_UNIT,
+    				 uint64_t count = FLASH_FOR_EVER,
+    				 int core = FLASH_TASK_CORE );
+
+    /** put a pattern with a priority on top of the running asynchronous patterns, none blocking.
+     *  The pattern with the highest priority drives the LED. The lower layers keep running in the dark
+     *  and continue in phase when the overlay ends. If no lower layer is active the LED
+     *  gets the lightening state back it had when the flash thread was started.
+     *  An overlay of the same priority gets replaced.
+     *  @param priority: layer 1..MAX_OVERLAY, the base layer 0 is used by async_flash() and async_morse().
+     *  @param a_pattern: the pattern to be played. It is not copied and must stay valid while the overlay runs.
+     *  @param count: number of times the pattern is played.
+     *  @param core_no: core to run the flash thread, if it has to be started.
+     *  @return pdPASS or 0 on success, otherwise an error code of xTaskCreatePinnedToCore().
+     *          -1 if the priority is invalid.
+     */
+    int async_overlay( unsigned priority,
+    				   const GLedPattern & a_pattern,
+    				   uint64_t count = 1,
+    				   int core = FLASH_TASK_CORE );
+
+    /** async_overlay() to be called from an interrupt service routine.
+     *  The layer is set directly and a running flash thread is notified.
+     *  Otherwise the start of the flash thread is requested from the GLed ISR task (task_gled_isr),
+     *  which is started with the first request. The pattern must be placed in RAM (not const in flash).
+     *  @param priority: layer 1..MAX_OVERLAY.
+     *  @param a_pattern: the pattern to be played. It is not copied and must stay valid while the overlay runs.
+     *  @param count: number of times the pattern is played.
+     *  @param task_woken: set to pdTRUE if a task switch should be requested
+     *                     before the ISR exits, see xQueueSendFromISR().
+     *  @return false if the priority is invalid, the LED is not activated or the request queue is full.
+     */
+    bool IRAM_ATTR async_overlay_from_isr( unsigned priority,
+    									   const GLedPattern & a_pattern,
+    									   uint64_t count,
+    									   BaseType_t *task_woken );
+
+    /**
+     * end an overlay before its count has expired.
+     * @param priority: layer 1..MAX_OVERLAY.
+     */
+    void cancel_overlay( unsigned priority );
+
+    /**
+     * get the number of remaining repetitions of the async_flash() or async_morse() sequence.
+     * @returns the remaining count of the base layer, FLASH_FOR_EVER for an endless sequence,
+     *          0 if the sequence has finished or was stopped.
+     */
+    uint64_t remaining_flashes() const { return layers[0].pattern == nullptr ? 0 : api_count( layers[0].count ); }
+
+    /**
+     * check if any asynchronous pattern, overlay or the activity light is active.
+     * @returns true while flashing.
+     */
+    bool is_flashing() const;
+
+    /**
+     * get the time of the next switching edge of the flash thread.
+     * @param tick: receives the tick count (see xTaskGetTickCount()) of the next edge, unchanged if there is none.
+     * @returns true while the LED is flashing, false if no edge is scheduled.
+     */
+    bool next_edge_time( TickType_t & tick ) const;
+
+    /**
+     * register a function which is called when all asynchronous patterns have expired.
+     * The function is called in the context of the flash thread,
+     * it must not call reconnect_to_pin() of this LED.
+     * It is not called if the patterns are terminated by end().
+     * @param callback: function to be called, nullptr to remove the callback.
+     * @param arg: argument passed to the callback.
+     */
+    void on_flash_done( gled_done_callback_t callback, void *arg = nullptr ) { done_callback = callback; done_arg = arg; }
+
+    /**
+     * register event group bits which are set when all asynchronous patterns have expired,
+     * and cleared when a new pattern is started.
+     * So a task may wait for the end of a sequence with xEventGroupWaitBits().
+     * @param group: the event group, nullptr to remove it.
+     * @param bits: the bits to be set.
+     */
+    void set_done_event( EventGroupHandle_t group, EventBits_t bits ) { done_group = group; done_bits = bits; }
+
+    /**
+     * use the LED as an activity light, e.g. for network or disk traffic.
+     * The events are signaled by trigger_activity(). The flash thread turns them into
+     * visible pulses: a pulse is on for at least dt_on_min and gets extended as long as
+     * further events arrive (retriggerable), between two pulses the LED is off for at least dt_off_min.
+     * The thread samples the events every dt_off_min while idle.
+     * The activity light is below all layers, async_flash() and async_overlay() patterns hide it.
+     * @param dt_on_min: minimal on time of a pulse (ms).
+     * @param dt_off_min: minimal off time between two pulses (ms).
+     * @param core_no: core to run the flash thread, if it has to be started.
+     * @return pdPASS or 0 on success, otherwise an error code of xTaskCreatePinnedToCore().
+     */
+    int activity_mode( unsigned dt_on_min = DEFAULT_ACTIVITY_ON_TIME,
+    				   unsigned dt_off_min = DEFAULT_ACTIVITY_OFF_TIME,
+    				   int core = FLASH_TASK_CORE );
+
+    /**
+     * end the activity light mode. The flash thread terminates if no pattern layer is active.
+     */
+    void stop_activity_mode();
+
+    /**
+     * signal an activity event. It is a single atomic store, wait free and
+     * may be called at any rate from any task or an interrupt service routine.
+     * Without activity_mode() the events are ignored.
+     */
+    inline void IRAM_ATTR trigger_activity() { activity_pending.store( 1, std::memory_order_relaxed ); }
+
+    /**
+     * breathe - let the activated LED fade up and down continuously ("breathing" LED).
+     * The fading is done by the LEDC hardware. At the end of each fade the LEDC interrupt
+     * hands the LED to a shared fade task which only starts the opposite hardware fade,
+     * so a breathing LED costs two interrupts per period and no duty stepping by the CPU.
+     * A LED of a dimmable backend (see GLedPCA9685) is faded by the backend.
+     * A running flash task gets terminated. The breathing ends with the next
+     * on(), off(), flash(), async_flash() or end() call.
+     * If the LED is already breathing the new values are used with the next fade.
+     * @param period_ms: duration of a full fade up and fade down cycle (ms).
+     * @param min: lowest brightness (0..255).
+     * @param max: highest brightness (0..255).
+     * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the LED is not activated,
+     *         ESP_ERR_NOT_FOUND if no free LEDC channel is left,
+     *         ESP_ERR_NOT_SUPPORTED for a LED of a backend which can not dim,
+     *         otherwise the error code of the LEDC driver.
+     */
+    esp_err_t breathe( unsigned period_ms = 2000, uint8_t min = 0, uint8_t max = 255 );
+
+    /**
+     * check if the LED is breathing.
+     * @returns true if a breathe() fade cycle is running.
+     */
+    bool is_breathing() const { return breathing; }
+
+    /**
+     * let the LED shine with a reduced brightness. The LEDC or the sigma-delta modulator
+     * (see set_dimmer()) dims the LED, no CPU time is used. A running flash task or breathing gets terminated.
+     * The dimming ends with the next on(), off(), flash(), async_flash() or end() call.
+     * @param level: brightness 0..255.
+     * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the LED is not activated,
+     *         ESP_ERR_NOT_FOUND if no free LEDC or sigma-delta channel is left,
+     *         ESP_ERR_NOT_SUPPORTED for a LED of a backend which can not dim,
+     *         otherwise the error code of the LEDC or sigma-delta driver.
+     */
+    esp_err_t set_brightness( uint8_t level );
+
+    /**
+     * select the peripheral which dims the LED in set_brightness().
+     * The sigma-delta modulator has 8 channels (4 on some variants) and needs no timer,
+     * so the LEDC channels stay free for other purposes. It has no hardware fade,
+     * breathe() always uses the LEDC. A LED dimmed by the old dimmer shines at full brightness
+     * until the next set_brightness().
+     * @param a_dimmer: DIMMER_LEDC (default) or DIMMER_SIGMA_DELTA.
+     */
+    void set_dimmer( gled_dimmer_t a_dimmer );
+
+    /**
+     * get the peripheral which dims the LED in set_brightness().
+     */
+    gled_dimmer_t get_dimmer() const { return dimmer; }
+
+    /**
+     * set the color of a LED of a color backend, see GLedPixels.
+     * The color is used whenever the LED is on, the switching and flashing methods are not affected.
+     * @param rgb: color 0xRRGGBB.
+     * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED for a LED without colors.
+     */
+    esp_err_t set_color( uint32_t rgb ) { return backend != nullptr ? backend->set_color( pin, rgb ) : ESP_ERR_NOT_SUPPORTED; }
+
 
     /**
      * Reassign the pin which is connected to the LED.
@@ -251,6 +538,7 @@ public:
      * \note The gpio pin state of the previously controlled LED pin is set to led off and
      *       a running flash task gets terminated. But the gpio pin configuration itself is not changed.
      *
+     * A LED of a backend keeps the backend, the pin is the new channel.
      *  @param pin   new controlling GPIO pin.
      *  @param logic if HIGH_IS_ACTIVE it is assumed that the LED is lightening if its gpio port ist HIGH.
      * And that the LED is off when the gpio pin is set to LOW. On LOW_IS_ACTIVE the switching logic is reverse.
@@ -258,17 +546,117 @@ public:
     void reconnect_to_pin( int pin, gled_switching_logic_t logic = GLed::HIGH_IS_ACTIVE  );
 
 private:
-    int pin;
-    int state;
-    volatile bool activated;
+    int pin;                           ///< gpio number, or channel of the backend.
+    GLedBackend * backend;             ///< driver of an external device, nullptr for a native gpio.
+    std::atomic<int> state { 0 };
+    std::atomic<bool> activated { false };
     bool on_is_high_level;
-    volatile uint64_t flash_count;
-    volatile unsigned flash_dt_on;
-	volatile unsigned flash_dt_off;
-    TaskHandle_t flash_task_handle;
+    // a pattern layer, played by the flash task:
+    typedef struct {
+        std::atomic<const GLedPattern *> pattern;  ///< nullptr if the layer is not active.
+        std::atomic<uint32_t> count;               ///< remaining repetitions of the pattern, LAYER_FOR_EVER if endless.
+        std::atomic<bool> restart;                 ///< request to the flash task: start the pattern at "start".
+        std::atomic<TickType_t> start;             ///< tick of the requested start, read by the flash task after "restart".
+        unsigned step;                             ///< interval of the pattern currently played, owned by the flash task.
+        TickType_t step_end;
+    } gled_layer_t;
+
+    gled_layer_t layers[GLED_LAYERS] {};   ///< layers[0] is the base layer of async_flash() and async_morse().
+    std::atomic<unsigned> flash_dt_on { 0 };
+    std::atomic<unsigned> flash_dt_off { 0 };
+    std::atomic<TaskHandle_t> flash_task_handle { nullptr };   ///< published by the flash task itself.
+    std::atomic<bool> flash_task_running { false };     ///< a flash task plays the layers, new ones only wake it up.
+    std::atomic<uint32_t> flash_task_count { 0 };      ///< flash tasks not yet deleted, including one being created.
+    std::atomic<uint32_t> flash_task_generation { 0 }; ///< changed by stop_flash_task(), the task started before terminates.
+    std::atomic<uint32_t> flash_task_wakers { 0 };     ///< callers using flash_task_handle, see wake_flash_task().
+    GLedPattern patterns[GLED_PATTERN_BUFFERS];   ///< patterns of the base layer, see claim_pattern().
+    std::atomic<uint8_t> pattern_claims { 0 };   ///< bit n: a writer fills patterns[n].
+    std::atomic<const GLedPattern *> pattern_hazard { nullptr };   ///< base layer pattern read by the flash task.
+    int ledc_channel = -1;             ///< LEDC channel used by breathe(), -1 if none is assigned.
+    gled_dimmer_t dimmer = DIMMER_LEDC;   ///< peripheral used by set_brightness().
+    int sdm_channel = -1;              ///< sigma-delta channel, -1 if none is assigned.
+    std::atomic<bool> dimmer_attached { false };   ///< the pin is driven by the LEDC or the sigma-delta modulator: breathing or dimmed.
+    std::atomic<bool> breathing { false };
+    std::atomic<uint32_t> isr_requests { 0 };   ///< requests of this LED queued for task_gled_isr, end() waits for them.
+    volatile bool fade_up = false;     ///< direction of the currently running hardware fade.
+    volatile unsigned breathe_dt = 0;  ///< duration of a single fade [ms].
+    volatile uint8_t breathe_min = 0;
+    volatile uint8_t breathe_max = 0;
+    std::atomic<TickType_t> next_edge { 0 };   ///< tick count of the next edge of the flash task, if next_edge_valid.
+    std::atomic<bool> next_edge_valid { false };   ///< the flash task sleeps until next_edge.
+    gled_done_callback_t done_callback = nullptr;
+    void * done_arg = nullptr;
+    EventGroupHandle_t done_group = nullptr;
+    EventBits_t done_bits = 0;
+    std::atomic<uint32_t> activity_pending { 0 };   ///< set by trigger_activity(), cleared by the flash task.
+    volatile bool activity_enabled = false;
+    bool activity_on = false;          ///< state of the activity light, owned by the flash task.
+    TickType_t activity_until = 0;     ///< end of the current activity pulse or gap.
+    volatile TickType_t activity_dt_on = 0;
+    volatile TickType_t activity_dt_off = 0;
+
+    // the count of a layer has 32 bits, so it is changed lock-free also on the 32 bit cores.
+    static const uint32_t LAYER_FOR_EVER = UINT32_MAX;
+
+    /// count of the API for the count of a layer.
+    static uint64_t api_count( uint32_t count ) { return count == LAYER_FOR_EVER ? FLASH_FOR_EVER : count; }
+
+    static volatile TickType_t wake_alignment;   ///< see set_wake_alignment() [ticks]
+
+    /// round the end of a pattern period up to the alignment grid.
+    static TickType_t align_wake( TickType_t wake )
+    {
+        const TickType_t a = wake_alignment;
+        return a > 1 ? (wake + a - 1) / a * a : wake;
+    }
+
+    /// gpio level which makes the LED lightening or dark.
+    bool gpio_level( bool lightening ) const { return lightening == on_is_high_level; }
+
+    /// duty of the output for a brightness, inverted for a LOW_IS_ACTIVE LED.
+    uint8_t output_duty( uint8_t brightness ) const { return on_is_high_level ? brightness : 255 - brightness; }
+
+    /// end breathe() or set_brightness() before the LED gets switched.
+    void end_dimming()
+    {
+        if( dimmer_attached )
+            detach_dimmer();
+        else if( breathing )   // a backend ends the fading with the next write.
+            breathing = false;
+    }
+
+    void write_state( int s, bool force = false );
+    void IRAM_ATTR write_state_from_isr( int s );
+    GLedPattern * claim_pattern();
+    void release_pattern( const GLedPattern * p );
+    const GLedPattern * protect_pattern();
+    bool play_flash( uint64_t count, unsigned dt_on, unsigned dt_off, bool restart, TickType_t start );
+    void start_layer( unsigned layer, const GLedPattern & a_pattern, uint64_t count, bool restart, TickType_t now );
+    void stop_layers();
+    static bool advance_layer( gled_layer_t & l, const GLedPattern * p, TickType_t now );
+    static void expire_layer( gled_layer_t & l, const GLedPattern * p, uint32_t c );
+    TickType_t advance_activity( TickType_t now );
+    int start_flash_task( int core_num );
+    void wake_flash_task();
+    void stop_flash_task();
+    esp_err_t attach_ledc( uint32_t duty );
+    esp_err_t attach_sdm( uint8_t level );
+    void detach_dimmer();
+    void release_dimmer_channels();
+    bool queue_isr_request( uint8_t request, BaseType_t *task_woken );
 
 friend
 	void task_flash( void *pvParameters );
+friend
+	void task_gled_isr( void *pvParameters );
+friend
+	bool on_fade_end( const ledc_cb_param_t *param, void *user_arg );
+friend
+	class GLedTimeline;
+friend
+	class GLedService;
+friend
+	class GLedUlp;
 };
 
 #endif
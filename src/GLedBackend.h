@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       output drivers for LEDs not connected to a native gpio.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedBackend.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_BACKEND_HEADER_H
+#define GLED_BACKEND_HEADER_H
+
+#include <Arduino.h>
+
+/// writes len bytes to the I2C device at the address in one transaction, see GLedExpander.
+typedef esp_err_t (*gled_i2c_write_t)( void *ctx, uint8_t address, const uint8_t *data, size_t len );
+
+/**
+ * A GLedBackend drives the outputs of an external device, for ex. a chain of shift registers.
+ * A GLed constructed with a backend uses a channel number of the device instead of a gpio pin,
+ * all switching and flashing methods work the same way.
+ * \n
+ * write() is called from several tasks at the same time and must not block,
+ * a backend collects the levels and transfers them in its own task.
+ * It should transfer only if a level has changed.
+ */
+class GLedBackend {
+public:
+    virtual ~GLedBackend() {};
+
+    /**
+     * prepare a channel as output, called by GLed::begin().
+     * @param channel: output number of the device.
+     * @return ESP_OK or ESP_ERR_INVALID_ARG if the device has no such output.
+     */
+    virtual esp_err_t attach( unsigned channel ) = 0;
+
+    /**
+     * set the level of an output.
+     * @param channel: output number of the device.
+     * @param level: true for HIGH, false for LOW.
+     */
+    virtual void write( unsigned channel, bool level ) = 0;
+
+    /**
+     * set the level of an output from an interrupt service routine.
+     * The call goes through the vtable in flash, so it must not be used while the flash cache is disabled.
+     * @param channel: output number of the device.
+     * @param level: true for HIGH, false for LOW.
+     */
+    virtual void write_from_isr( unsigned channel, bool level ) = 0;
+
+    /**
+     * set the duty of a dimmable output, see GLed::set_brightness().
+     * The next write() ends the dimming.
+     * @param channel: output number of the device.
+     * @param duty: time the output is HIGH, 0..255.
+     * @return ESP_OK or ESP_ERR_NOT_SUPPORTED if the device can not dim.
+     */
+    virtual esp_err_t set_brightness( unsigned, uint8_t ) { return ESP_ERR_NOT_SUPPORTED; }
+
+    /**
+     * fade a dimmable output forth and back, see GLed::breathe().
+     * The next write() or set_brightness() ends the fading.
+     * @param channel: output number of the device.
+     * @param period_ms: duration of a full cycle (ms).
+     * @param from: duty at the start of the cycle, 0..255.
+     * @param to: duty at the middle of the cycle, 0..255.
+     * @return ESP_OK or ESP_ERR_NOT_SUPPORTED if the device can not dim.
+     */
+    virtual esp_err_t breathe( unsigned, unsigned, uint8_t, uint8_t ) { return ESP_ERR_NOT_SUPPORTED; }
+
+    /**
+     * set the color of a color output, used while the output is on.
+     * @param channel: output number of the device.
+     * @param rgb: color 0xRRGGBB.
+     * @return ESP_OK or ESP_ERR_NOT_SUPPORTED if the device has no colors.
+     */
+    virtual esp_err_t set_color( unsigned, uint32_t ) { return ESP_ERR_NOT_SUPPORTED; }
+};
+
+#endif
+
+// eof
@@ -0,0 +1,217 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on an I2C port expander (MCP23017, PCA9555).
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedExpander.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedExpander.h"
+
+void task_gled_expander( void *pvParameters );
+
+// register of port A/0, the register of port B/1 follows.
+static const uint8_t MCP23017_IODIR = 0x00;
+static const uint8_t MCP23017_OLAT = 0x14;
+static const uint8_t PCA9555_OUTPUT = 0x02;
+static const uint8_t PCA9555_CONFIG = 0x06;
+
+GLedExpander::GLedExpander( chip_t a_chip, i2c_port_t a_port, uint8_t a_address )
+	: chip(a_chip)
+	, port(a_port)
+	, address(a_address)
+	, bus_write(i2c_write)
+	, bus_ctx(this)
+	, levels(0)
+	, outputs(0)
+	, sent_levels(0)
+	, sent_outputs(0)
+	, sent_valid(false)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transactions(0)
+	, errors(0)
+{
+}
+
+GLedExpander::GLedExpander( chip_t a_chip, uint8_t a_address, bus_write_t a_bus_write, void *ctx )
+	: chip(a_chip)
+	, port(0)
+	, address(a_address)
+	, bus_write(a_bus_write)
+	, bus_ctx(ctx)
+	, levels(0)
+	, outputs(0)
+	, sent_levels(0)
+	, sent_outputs(0)
+	, sent_valid(false)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transactions(0)
+	, errors(0)
+{
+}
+
+GLedExpander::~GLedExpander()
+{
+	end();
+}
+
+esp_err_t GLedExpander::begin( int core_num )
+{
+	if( task_handle != nullptr )
+		return ESP_OK;
+
+	quit = false;
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_expander, "task_gled_expander", 2048, this, 1, & handle, core_num ) != pdPASS )
+		return ESP_ERR_NO_MEM;
+	task_handle = handle;
+	if( dirty )   // LEDs attached before.
+		xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+void GLedExpander::end()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( handle == nullptr )
+		return;
+
+	quit = true;
+	xTaskNotifyGive( handle );
+	while( task_handle != nullptr )
+		vTaskDelay( 1 );
+}
+
+esp_err_t GLedExpander::attach( unsigned channel )
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( channel >= OUTPUTS )
+		return ESP_ERR_INVALID_ARG;
+
+	outputs.fetch_or( 1u << channel );
+	if( mark_dirty() && handle != nullptr )
+		xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+bool GLedExpander::mark_dirty()
+{
+	return ! dirty.exchange( true );
+}
+
+void GLedExpander::write( unsigned channel, bool level )
+{
+	const TaskHandle_t handle = task_handle;
+	const uint32_t bit = 1u << channel;
+
+	if( channel >= OUTPUTS )
+		return;
+
+	const uint32_t old = level ? levels.fetch_or( bit ) : levels.fetch_and( ~bit );
+	if( ((old & bit) != 0) != level && mark_dirty() && handle != nullptr )
+		xTaskNotifyGive( handle );
+}
+
+void IRAM_ATTR GLedExpander::write_from_isr( unsigned channel, bool level )
+{
+	const TaskHandle_t handle = task_handle;
+	const uint32_t bit = 1u << channel;
+
+	if( channel >= OUTPUTS )
+		return;
+
+	const uint32_t old = level ? levels.fetch_or( bit ) : levels.fetch_and( ~bit );
+	if( ((old & bit) != 0) != level && ! dirty.exchange( true ) && handle != nullptr )
+		vTaskNotifyGiveFromISR( handle, nullptr );
+}
+
+esp_err_t GLedExpander::flush()
+{
+	esp_err_t rc;
+
+	if( ! dirty.exchange( false ) )
+		return ESP_OK;
+
+	const uint32_t new_levels = levels;
+	const uint32_t new_outputs = outputs;
+
+	// the output latches first, so a new output starts with the right level:
+	if( ! sent_valid || new_levels != sent_levels ) {
+		rc = write_register_pair( chip == MCP23017 ? MCP23017_OLAT : PCA9555_OUTPUT, new_levels );
+		if( rc != ESP_OK ) {
+			dirty = true;   // the transfer task retries, a write does not notify it while dirty.
+			sent_valid = false;
+			return rc;
+		}
+		sent_levels = new_levels;
+	}
+	if( ! sent_valid || new_outputs != sent_outputs ) {
+		// a set bit configures an input:
+		rc = write_register_pair( chip == MCP23017 ? MCP23017_IODIR : PCA9555_CONFIG, ~new_outputs );
+		if( rc != ESP_OK ) {
+			dirty = true;
+			sent_valid = false;
+			return rc;
+		}
+		sent_outputs = new_outputs;
+	}
+	sent_valid = true;
+	return ESP_OK;
+}
+
+esp_err_t GLedExpander::write_register_pair( uint8_t reg, uint32_t value )
+{
+	const uint8_t data[3] = { reg, (uint8_t) value, (uint8_t) (value >> 8) };
+
+	transactions++;
+	const esp_err_t rc = bus_write( bus_ctx, address, data, sizeof(data) );
+	if( rc != ESP_OK )
+		errors++;
+	return rc;
+}
+
+esp_err_t GLedExpander::i2c_write( void *ctx, uint8_t address, const uint8_t *data, size_t len )
+{
+	return i2c_master_write_to_device( ((GLedExpander*) ctx)->port, address, data, len, pdMS_TO_TICKS( I2C_TIMEOUT ) );
+}
+
+void task_gled_expander( void *pvParameters )
+{
+	GLedExpander * pExpander = (GLedExpander*) pvParameters;
+	TickType_t wait = portMAX_DELAY;
+
+	while( ! pExpander->quit ) {
+		ulTaskNotifyTake( pdTRUE, wait );
+		vTaskDelay( GLED_EXPANDER_COALESCE_TICKS );   // collect the changes of this tick.
+		// the changes stay pending after a bus error, the writes meanwhile do not notify:
+		wait = pExpander->flush() == ESP_OK ? portMAX_DELAY : pdMS_TO_TICKS( GLED_EXPANDER_RETRY_MS );
+	}
+	pExpander->flush();
+
+	pExpander->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+// eof
@@ -0,0 +1,138 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on an I2C port expander (MCP23017, PCA9555).
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedExpander.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_EXPANDER_HEADER_H
+#define GLED_EXPANDER_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/i2c.h>
+
+#include "GLed.h"
+#include "GLedBackend.h"
+
+// ticks the transfer task waits after the first change, to collect further changes into the same transfer.
+#ifndef GLED_EXPANDER_COALESCE_TICKS
+#define GLED_EXPANDER_COALESCE_TICKS 1
+#endif
+
+// pause before a failed transfer is repeated [ms], the changes meanwhile go into the same transfer.
+#ifndef GLED_EXPANDER_RETRY_MS
+#define GLED_EXPANDER_RETRY_MS 100
+#endif
+
+/**
+ * The GLedExpander drives LEDs on the 16 outputs of an I2C port expander.
+ * An I2C transfer takes some 100 us, so the LEDs only change a frame of 16 bits.
+ * The first change wakes up a transfer task, which waits for GLED_EXPANDER_COALESCE_TICKS
+ * and then writes both output ports with one transfer. So all changes of the LEDs
+ * in one scheduler tick cost a single bus transaction, unchanged frames are not sent.
+ * \n
+ * Output 0..7 are GPA0..GPA7 (MCP23017) or P0_0..P0_7 (PCA9555), output 8..15 the second port.
+ * Only the outputs of a GLed are configured as output, the other pins stay inputs.
+ * \n
+ * The I2C driver of the port has to be installed before begin(), for ex. by i2c_driver_install()
+ * or by Wire.begin() of the Arduino core 2.x. Instead of the I2C driver a bus write function
+ * may be given, for ex. the one of the mock expander in extras/host.
+ */
+class GLedExpander : public GLedBackend {
+public:
+    enum chip_t { MCP23017, PCA9555 };   ///< supported expander types.
+
+    typedef gled_i2c_write_t bus_write_t;   ///< writes a transaction, see GLedBackend.h.
+
+    static const unsigned OUTPUTS = 16;          ///< outputs of an expander.
+    static const int I2C_TIMEOUT = 10;           ///< timeout of an I2C transfer [ms]
+
+    /**
+     * @param chip: expander type.
+     * @param port: I2C port, for ex. I2C_NUM_0.
+     * @param address: 7 bit I2C address, for ex. 0x20.
+     */
+    GLedExpander( chip_t chip, i2c_port_t port, uint8_t address );
+
+    /**
+     * use a bus write function instead of the I2C driver.
+     * @param chip: expander type.
+     * @param address: 7 bit I2C address.
+     * @param bus_write: function writing a transaction.
+     * @param ctx: first argument of bus_write.
+     */
+    GLedExpander( chip_t chip, uint8_t address, bus_write_t bus_write, void *ctx );
+
+    ~GLedExpander();
+
+    /**
+     * start the transfer task.
+     * @param core: core to run the transfer task.
+     * @return ESP_OK or ESP_ERR_NO_MEM.
+     */
+    esp_err_t begin( int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the transfer task, pending changes are sent before.
+     */
+    void end();
+
+    /**
+     * send the pending changes now, in the context of the caller.
+     * Meant for use without the transfer task, for ex. on the host.
+     * After an error the changes stay pending and the next flush() sends them again,
+     * the transfer task repeats a failed transfer after GLED_EXPANDER_RETRY_MS.
+     * @return ESP_OK or the error code of the bus.
+     */
+    esp_err_t flush();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+
+    uint32_t get_transactions() const { return transactions; }   ///< number of bus transactions.
+    uint32_t get_errors() const { return errors; }               ///< number of failed bus transactions.
+
+private:
+    chip_t chip;
+    i2c_port_t port;
+    uint8_t address;
+    bus_write_t bus_write;
+    void * bus_ctx;
+    std::atomic<uint32_t> levels;      ///< level of output n is bit n.
+    std::atomic<uint32_t> outputs;     ///< attached outputs.
+    uint32_t sent_levels;              ///< frame of the last transfer.
+    uint32_t sent_outputs;             ///< direction of the last transfer.
+    bool sent_valid;                   ///< the device holds sent_levels and sent_outputs.
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<bool> dirty;
+    std::atomic<uint32_t> transactions;
+    std::atomic<uint32_t> errors;
+
+    esp_err_t write_register_pair( uint8_t reg, uint32_t value );
+    bool mark_dirty();
+    static esp_err_t i2c_write( void *ctx, uint8_t address, const uint8_t *data, size_t len );
+
+friend
+    void task_gled_expander( void *pvParameters );
+};
+
+#endif
+
+// eof
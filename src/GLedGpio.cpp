@@ -0,0 +1,29 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       batched gpio output for several LEDs.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGpio.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include "GLedGpio.h"
+
+std::atomic<uint32_t> GLedGpioCache::levels[GLED_GPIO_BANKS];
+std::atomic<uint32_t> GLedGpioCache::known[GLED_GPIO_BANKS];
+std::atomic<uint32_t> GLedGpioCache::elided( 0 );
+
+// eof
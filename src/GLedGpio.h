@@ -0,0 +1,203 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       batched gpio output for several LEDs.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGpio.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_GPIO_HEADER_H
+#define GLED_GPIO_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <soc/soc.h>
+#include <soc/soc_caps.h>
+#include <soc/gpio_reg.h>
+
+// number of 32 bit gpio output registers (banks).
+#define GLED_GPIO_BANKS ((SOC_GPIO_PIN_COUNT + 31) / 32)
+
+/**
+ * set the level of a single gpio output pin by a direct register write.
+ * May be used in an interrupt service routine.
+ * @param pin: gpio number.
+ * @param level: true for HIGH, false for LOW.
+ */
+static inline void gled_gpio_write( int pin, bool level ) __attribute__((always_inline));
+static inline void gled_gpio_write( int pin, bool level )
+{
+#if GLED_GPIO_BANKS > 1
+    if( pin >= 32 ) {
+        REG_WRITE( level ? GPIO_OUT1_W1TS_REG : GPIO_OUT1_W1TC_REG, 1u << (pin - 32) );
+        return;
+    }
+#endif
+    REG_WRITE( level ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, 1u << pin );
+}
+
+/**
+ * The GLedGpioCache keeps the last level written to each gpio output pin, one bit per pin in each bank.
+ * A write of an unchanged level is skipped and counted as elided.
+ * A pin is elided only after it has been written once with force, for ex. by GLed::begin(),
+ * as the level of the pin is unknown before.
+ * \n
+ * A writer racing with another writer of the same pin has to check the result afterwards
+ * and correct it with force, see GLed::write_state().
+ */
+class GLedGpioCache {
+public:
+    /**
+     * record the level of a pin before it is written.
+     * May be used in an interrupt service routine.
+     * @param pin: gpio number.
+     * @param level: true for HIGH, false for LOW.
+     * @param force: the pin has to be written in any case.
+     * @return true if the pin has to be written, false if it has the level already.
+     */
+    static inline bool update( int pin, bool level, bool force = false ) __attribute__((always_inline))
+    {
+        const int bank = pin >> 5;
+        const uint32_t bit = 1u << (pin & 31);
+        const uint32_t old = level ? levels[bank].fetch_or( bit ) : levels[bank].fetch_and( ~bit );
+
+        if( force ) {
+            known[bank].fetch_or( bit );
+            return true;
+        }
+        if( (known[bank].load( std::memory_order_relaxed ) & bit) && ((old & bit) != 0) == level ) {
+            elided.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+        known[bank].fetch_or( bit );
+        return true;
+    }
+
+    /**
+     * forget the level of a pin, the next write is not elided.
+     * @param pin: gpio number.
+     */
+    static void forget( int pin ) { known[pin >> 5].fetch_and( ~(1u << (pin & 31)) ); }
+
+    /**
+     * get the number of writes elided since start.
+     */
+    static uint32_t get_elided() { return elided.load( std::memory_order_relaxed ); }
+
+private:
+    static std::atomic<uint32_t> levels[GLED_GPIO_BANKS];   ///< last level written per pin
+    static std::atomic<uint32_t> known[GLED_GPIO_BANKS];    ///< pins with a valid level
+    static std::atomic<uint32_t> elided;
+
+friend
+    class GLedGpioMask;
+};
+
+/**
+ * A GLedGpioMask collects level changes of several gpio pins and
+ * writes them with the set and clear registers of each bank at once.
+ * So all changes become visible at the same instant, without any skew between the LEDs,
+ * and pins not in the mask are not touched.
+ */
+class GLedGpioMask {
+public:
+    GLedGpioMask() { clear(); }
+
+    /**
+     * forget all collected changes.
+     */
+    void clear()
+    {
+        for( int i = 0; i < GLED_GPIO_BANKS; i++ )
+            set_bits[i] = clear_bits[i] = 0;
+    }
+
+    /**
+     * add a pin level to the mask. A later call for the same pin overrides an earlier one.
+     * @param pin: gpio number.
+     * @param level: true for HIGH, false for LOW.
+     */
+    void add( int pin, bool level )
+    {
+        const int bank = pin >> 5;
+        const uint32_t bit = 1u << (pin & 31);
+
+        if( level ) {
+            set_bits[bank] |= bit;
+            clear_bits[bank] &= ~bit;
+        }
+        else {
+            clear_bits[bank] |= bit;
+            set_bits[bank] &= ~bit;
+        }
+    }
+
+    /**
+     * check if any change is collected.
+     */
+    bool empty() const
+    {
+        for( int i = 0; i < GLED_GPIO_BANKS; i++ )
+            if( set_bits[i] | clear_bits[i] )
+                return false;
+        return true;
+    }
+
+    /**
+     * drop the pins which have the collected level already, see GLedGpioCache.
+     * Call it once right before write().
+     */
+    void elide()
+    {
+        for( int i = 0; i < GLED_GPIO_BANKS; i++ ) {
+            const uint32_t known = GLedGpioCache::known[i].fetch_or( set_bits[i] | clear_bits[i] );
+            const uint32_t was_set = GLedGpioCache::levels[i].fetch_or( set_bits[i] );
+            const uint32_t was_clear = ~GLedGpioCache::levels[i].fetch_and( ~clear_bits[i] );
+            const uint32_t unchanged = known & ((set_bits[i] & was_set) | (clear_bits[i] & was_clear));
+
+            if( unchanged ) {
+                set_bits[i] &= ~unchanged;
+                clear_bits[i] &= ~unchanged;
+                GLedGpioCache::elided.fetch_add( __builtin_popcount( unchanged ), std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /**
+     * write the collected levels to the gpio output registers.
+     */
+    inline void write() const __attribute__((always_inline))
+    {
+        if( set_bits[0] )
+            REG_WRITE( GPIO_OUT_W1TS_REG, set_bits[0] );
+        if( clear_bits[0] )
+            REG_WRITE( GPIO_OUT_W1TC_REG, clear_bits[0] );
+#if GLED_GPIO_BANKS > 1
+        if( set_bits[1] )
+            REG_WRITE( GPIO_OUT1_W1TS_REG, set_bits[1] );
+        if( clear_bits[1] )
+            REG_WRITE( GPIO_OUT1_W1TC_REG, clear_bits[1] );
+#endif
+    }
+
+private:
+    uint32_t set_bits[GLED_GPIO_BANKS];
+    uint32_t clear_bits[GLED_GPIO_BANKS];
+};
+
+#endif
+
+// eof
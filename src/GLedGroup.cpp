@@ -0,0 +1,241 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on a bundle of dedicated gpios, written by single cpu instructions.
+// premises:	   ESP32-S2, ESP32-S3, ESP32-C3 or another variant with dedicated gpios.
+// remarks:        on variants without dedicated gpios the gpio output registers are used.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGroup.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedGroup.h"
+
+#if GLED_GROUP_DEDICATED
+// write the masked dedicated gpio outputs of the current core, a single instruction.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <hal/dedic_gpio_cpu_ll.h>
+#define GLED_DEDIC_WRITE( mask, value ) dedic_gpio_cpu_ll_write_mask( mask, value )
+#else
+#include <hal/cpu_ll.h>
+#define GLED_DEDIC_WRITE( mask, value ) cpu_ll_write_dedic_gpio_mask( mask, value )
+#endif
+
+void task_gled_group( void *pvParameters );
+#endif
+
+static const char* TAG = "GLED";
+
+GLedGroup::GLedGroup( const int *pins, unsigned a_count )
+	: pin()
+	, count(a_count < GLED_GROUP_MAX_PINS ? a_count : GLED_GROUP_MAX_PINS)
+	, all((1u << count) - 1)
+	, ready(false)
+#if GLED_GROUP_DEDICATED
+	, bundle(nullptr)
+	, offset(0)
+	, core(0)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(0)
+#endif
+	, levels(0)
+	, deferred(0)
+{
+	for( unsigned n = 0; n < count; n++ )
+		pin[n] = pins[n];
+}
+
+GLedGroup::~GLedGroup()
+{
+	end();
+}
+
+esp_err_t GLedGroup::begin()
+{
+	if( ready )
+		return ESP_OK;
+
+	for( unsigned n = 0; n < count; n++ ) {
+		digitalWrite( pin[n], (levels >> n) & 1 ? HIGH : LOW );
+		pinMode( pin[n], OUTPUT );
+	}
+
+#if GLED_GROUP_DEDICATED
+	esp_err_t rc;
+	dedic_gpio_bundle_config_t config = {};
+	config.gpio_array = pin;
+	config.array_size = count;
+	config.flags.out_en = 1;
+	if( (rc = dedic_gpio_new_bundle( &config, &bundle )) != ESP_OK ) {
+		bundle = nullptr;
+		return rc;
+	}
+
+	uint32_t out_mask = 0;
+	dedic_gpio_get_out_mask( bundle, &out_mask );
+	offset = out_mask != 0 ? __builtin_ctz( out_mask ) : 0;
+	core = xPortGetCoreID();
+
+	quit = false;
+	dirty = 0;
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_group, "task_gled_group", 2048, this, 2, & handle, core ) != pdPASS ) {
+		dedic_gpio_del_bundle( bundle );
+		bundle = nullptr;
+		return ESP_ERR_NO_MEM;
+	}
+	task_handle = handle;
+	GLED_DEDIC_WRITE( all << offset, levels << offset );
+
+	ESP_LOGI( TAG, "group of %u pins: dedicated gpio channels %u..%u of core %d", count, offset, offset + count - 1, core );
+#else
+	ESP_LOGI( TAG, "group of %u pins: no dedicated gpios, the gpio registers are used", count );
+#endif
+
+	ready = true;
+	return ESP_OK;
+}
+
+void GLedGroup::end()
+{
+	if( ! ready )
+		return;
+	ready = false;
+
+#if GLED_GROUP_DEDICATED
+	const TaskHandle_t handle = task_handle;
+
+	if( handle != nullptr ) {
+		quit = true;
+		xTaskNotifyGive( handle );
+		while( task_handle != nullptr )
+			vTaskDelay( 1 );
+	}
+	dedic_gpio_del_bundle( bundle );
+	bundle = nullptr;
+
+	// route the pins back to the gpio output registers.
+	for( unsigned n = 0; n < count; n++ ) {
+		digitalWrite( pin[n], (levels >> n) & 1 ? HIGH : LOW );
+		pinMode( pin[n], OUTPUT );
+	}
+#endif
+}
+
+esp_err_t GLedGroup::attach( unsigned channel )
+{
+	return channel < count ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void GLedGroup::write( unsigned channel, bool level )
+{
+	if( channel < count )
+		apply( level ? 1u << channel : 0, 1u << channel );
+}
+
+void IRAM_ATTR GLedGroup::write_from_isr( unsigned channel, bool level )
+{
+	if( channel < count )
+		apply( level ? 1u << channel : 0, 1u << channel );
+}
+
+void IRAM_ATTR GLedGroup::write_frame( uint32_t new_levels, uint32_t mask )
+{
+	apply( new_levels, mask & all );
+}
+
+esp_err_t IRAM_ATTR GLedGroup::pulse( uint32_t mask )
+{
+	if( ! ready )
+		return ESP_ERR_INVALID_STATE;
+
+	mask &= all & ~levels.load( std::memory_order_relaxed );
+#if GLED_GROUP_DEDICATED
+	if( xPortGetCoreID() != core )
+		return ESP_ERR_INVALID_STATE;
+	GLED_DEDIC_WRITE( mask << offset, mask << offset );
+	GLED_DEDIC_WRITE( mask << offset, 0 );
+#else
+	GLedGpioMask high, low;
+	for( unsigned n = 0; n < count; n++ ) {
+		if( mask & (1u << n) ) {
+			high.add( pin[n], true );
+			low.add( pin[n], false );
+		}
+	}
+	high.write();
+	low.write();
+#endif
+	return ESP_OK;
+}
+
+void IRAM_ATTR GLedGroup::apply( uint32_t new_levels, uint32_t mask )
+{
+	uint32_t old = levels.load( std::memory_order_relaxed );
+	while( ! levels.compare_exchange_weak( old, (old & ~mask) | (new_levels & mask) ) )
+		;
+
+	if( ! ready || mask == 0 )   // begin() sets the levels.
+		return;
+
+#if GLED_GROUP_DEDICATED
+	if( xPortGetCoreID() == core ) {
+		GLED_DEDIC_WRITE( mask << offset, new_levels << offset );
+		return;
+	}
+
+	// only the first hand over since the task ran wakes it up:
+	deferred.fetch_add( 1, std::memory_order_relaxed );
+	if( dirty.fetch_or( mask ) == 0 ) {
+		const TaskHandle_t handle = task_handle;
+		if( handle == nullptr )
+			return;
+		if( xPortInIsrContext() )
+			vTaskNotifyGiveFromISR( handle, nullptr );
+		else
+			xTaskNotifyGive( handle );
+	}
+#else
+	GLedGpioMask frame;
+	for( unsigned n = 0; n < count; n++ )
+		if( mask & (1u << n) )
+			frame.add( pin[n], (new_levels >> n) & 1 );
+	frame.write();
+#endif
+}
+
+#if GLED_GROUP_DEDICATED
+void task_gled_group( void *pvParameters )
+{
+	GLedGroup * pGroup = (GLedGroup*) pvParameters;
+
+	while( ! pGroup->quit ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		const uint32_t mask = pGroup->dirty.exchange( 0 );
+		// a write on this core must not come between reading and writing the levels:
+		portDISABLE_INTERRUPTS();
+		GLED_DEDIC_WRITE( mask << pGroup->offset, pGroup->levels.load() << pGroup->offset );
+		portENABLE_INTERRUPTS();
+	}
+
+	pGroup->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+#endif
+
+// eof
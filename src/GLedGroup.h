@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on a bundle of dedicated gpios, written by single cpu instructions.
+// premises:	   ESP32-S2, ESP32-S3, ESP32-C3 or another variant with dedicated gpios.
+// remarks:        on variants without dedicated gpios the gpio output registers are used.
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedGroup.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_GROUP_HEADER_H
+#define GLED_GROUP_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <soc/soc_caps.h>
+
+#include "GLedBackend.h"
+#include "GLedGpio.h"
+
+#if SOC_DEDICATED_GPIO_SUPPORTED
+#include <driver/dedic_gpio.h>
+#define GLED_GROUP_DEDICATED 1
+#else
+#define GLED_GROUP_DEDICATED 0
+#endif
+
+// highest number of pins of a group, the number of dedicated gpio output channels of a cpu.
+#define GLED_GROUP_MAX_PINS 8
+
+/**
+ * The GLedGroup drives up to 8 LEDs on native pins bundled to the dedicated gpios of a cpu core.
+ * A dedicated gpio is written by a cpu instruction instead of a bus access to the gpio matrix,
+ * so a write() of a LED or a write_frame() of all LEDs takes a single instruction,
+ * and pulse() makes timing markers a few cycles wide, for ex. for a logic analyzer.
+ * \n
+ * The bundle belongs to the core which called begin(). A write on the other core is handed over
+ * to a task pinned to the core of the bundle, so it becomes visible a little later.
+ * Tasks which need the single instruction path should run on the core of the bundle.
+ * \n
+ * Variants without dedicated gpios (ESP32) use the gpio output registers, see GLedGpioMask.
+ * All pins of a frame still change at the same instant there.
+ * \n
+ * Example:
+ * \code
+ * const int pins[] = { 1, 2, 3, 4 };
+ * GLedGroup group( pins, 4 );
+ * GLed led( group, 2 );
+ *
+ * group.begin();
+ * led.begin();
+ * led.async_flash();
+ * group.write_frame( 0x5 );   // pins 1 and 3 HIGH, 2 and 4 LOW, at once.
+ * \endcode
+ */
+class GLedGroup : public GLedBackend {
+public:
+    /**
+     * @param pins: gpio numbers, channel n of the group is pins[n].
+     * @param count: number of pins, at most GLED_GROUP_MAX_PINS.
+     */
+    GLedGroup( const int *pins, unsigned count );
+
+    ~GLedGroup();
+
+    /**
+     * bundle the pins to the dedicated gpios of the calling core and start the hand over task
+     * on this core. The calling task has to be pinned to its core, as the loop task of Arduino is.
+     * The pins get the levels written before, LOW by default.
+     * @return ESP_OK, ESP_ERR_NOT_FOUND if no dedicated gpio channels are free,
+     *         or the error code of the dedicated gpio driver.
+     */
+    esp_err_t begin();
+
+    /**
+     * stop the hand over task and release the bundle. The pins keep their levels as plain gpio outputs.
+     */
+    void end();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+
+    /**
+     * set the levels of several pins at once.
+     * May be used in an interrupt service routine.
+     * @param new_levels: level of channel n is bit n.
+     * @param mask: channels to be written, bit n for channel n.
+     */
+    void IRAM_ATTR write_frame( uint32_t new_levels, uint32_t mask = 0xff );
+
+    /**
+     * make a short HIGH pulse on pins which are LOW, the pulse is two instructions wide.
+     * It has to be called on the core of the bundle.
+     * @param mask: channels to pulse, bit n for channel n.
+     * @return ESP_OK or ESP_ERR_INVALID_STATE if called on the other core or before begin().
+     */
+    esp_err_t IRAM_ATTR pulse( uint32_t mask );
+
+    /**
+     * get the number of writes handed over to the task of the bundle core.
+     */
+    uint32_t get_deferred() const { return deferred; }
+
+private:
+    int pin[GLED_GROUP_MAX_PINS];
+    unsigned count;
+    uint32_t all;                       ///< bits of all channels.
+    volatile bool ready;
+#if GLED_GROUP_DEDICATED
+    dedic_gpio_bundle_handle_t bundle;
+    unsigned offset;                    ///< first dedicated gpio channel of the bundle.
+    int core;                           ///< core which owns the bundle.
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<uint32_t> dirty;        ///< channels written on the other core, not yet set.
+#endif
+    std::atomic<uint32_t> levels;       ///< level of channel n is bit n.
+    std::atomic<uint32_t> deferred;
+
+    void IRAM_ATTR apply( uint32_t new_levels, uint32_t mask );
+
+friend
+    void task_gled_group( void *pvParameters );
+};
+
+#endif
+
+// eof
@@ -0,0 +1,468 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       waveforms of up to 16 LEDs streamed by the I2S parallel mode DMA.
+// premises:	   ESP32 (the I2S LCD mode of the other variants differs).
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedI2S.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include "GLedI2S.h"
+
+#if CONFIG_IDF_TARGET_ESP32
+#include <esp_rom_gpio.h>
+#include <soc/soc.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/i2s_struct.h>
+#include <soc/i2s_reg.h>
+#include <soc/lldesc.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_private/periph_ctrl.h>
+#else
+#include <driver/periph_ctrl.h>
+#endif
+#endif
+
+// a buffer is sent as 32 bit words by a single DMA descriptor.
+#if GLED_I2S_BUFFER_SAMPLES % 2 != 0 || GLED_I2S_BUFFER_SAMPLES * 2 > 4092
+#error "GLED_I2S_BUFFER_SAMPLES must be even and at most 2046"
+#endif
+
+void task_gled_i2s( void *pvParameters );
+
+static const char* TAG = "GLED";
+
+GLedI2S::GLedI2S( const int *pins, unsigned a_count, int a_port )
+	: pin()
+	, count(a_count < GLED_I2S_MAX_CHANNELS ? a_count : GLED_I2S_MAX_CHANNELS)
+	, port(a_port)
+	, sample_rate(DEFAULT_SAMPLE_RATE)
+	, buffer()
+	, descriptors(nullptr)
+	, interrupt(nullptr)
+	, task_handle(nullptr)
+	, quit(false)
+	, running(false)
+	, requests()
+	, request()
+	, request_claims()
+	, request_hazard(nullptr)
+	, steady(0)
+	, changed(0)
+	, player()
+	, next(0)
+	, buffers(0)
+	, underruns(0)
+{
+	for( unsigned n = 0; n < count; n++ )
+		pin[n] = pins[n];
+}
+
+GLedI2S::~GLedI2S()
+{
+	end();
+}
+
+esp_err_t GLedI2S::begin( unsigned a_sample_rate, int core )
+{
+#if CONFIG_IDF_TARGET_ESP32
+	esp_err_t rc;
+
+	if( running )
+		return ESP_OK;
+
+	// LCD mode: sample rate = 80 MHz / clkm_div_num / tx_bck_div_num, with tx_bck_div_num = 2.
+	unsigned div = APB_CLK_FREQ / 2 / (a_sample_rate > 0 ? a_sample_rate : 1);
+	div = div < 2 ? 2 : div > 255 ? 255 : div;
+	sample_rate = APB_CLK_FREQ / 2 / div;
+
+	lldesc_t * desc = (lldesc_t*) heap_caps_calloc( GLED_I2S_BUFFERS, sizeof(lldesc_t), MALLOC_CAP_DMA );
+	descriptors = desc;
+	if( desc == nullptr ) {
+		release();
+		return ESP_ERR_NO_MEM;
+	}
+	for( int i = 0; i < GLED_I2S_BUFFERS; i++ ) {
+		buffer[i] = heap_caps_malloc( GLED_I2S_BUFFER_SAMPLES * 2, MALLOC_CAP_DMA );
+		if( buffer[i] == nullptr ) {
+			release();
+			return ESP_ERR_NO_MEM;
+		}
+	}
+
+	// a pattern played before may have no samples left at the new rate, the render task would never leave it:
+	for( unsigned n = 0; n < count; n++ ) {
+		if( player[n].pattern != nullptr && period_samples( *player[n].pattern, player[n].scale_us ) == 0 ) {
+			ESP_LOGW( TAG, "I2S%d stream: pattern of LED %u shorter than a sample at %u Hz, stopped", port, n, sample_rate );
+			player[n].pattern = nullptr;
+		}
+	}
+
+	// the whole ring is rendered before the start, the first buffer sent is the first to be refilled.
+	for( int i = 0; i < GLED_I2S_BUFFERS; i++ ) {
+		render( (uint16_t*) buffer[i] );
+		desc[i].size = GLED_I2S_BUFFER_SAMPLES * 2;
+		desc[i].length = GLED_I2S_BUFFER_SAMPLES * 2;
+		desc[i].buf = (uint8_t*) buffer[i];
+		desc[i].owner = 1;
+		desc[i].eof = 1;   // an interrupt for each buffer.
+		desc[i].qe.stqe_next = &desc[(i + 1) % GLED_I2S_BUFFERS];
+	}
+	next = 0;
+
+	quit = false;
+	TaskHandle_t handle;
+	// higher priority than the flash tasks: the refill has to be done before the DMA comes back.
+	if( xTaskCreatePinnedToCore( task_gled_i2s, "task_gled_i2s", 2048, this, 3, & handle, core ) != pdPASS ) {
+		release();
+		return ESP_ERR_NO_MEM;
+	}
+	task_handle = handle;
+
+	i2s_dev_t * dev = port == 0 ? &I2S0 : &I2S1;
+	periph_module_enable( port == 0 ? PERIPH_I2S0_MODULE : PERIPH_I2S1_MODULE );
+	running = true;
+
+	// reset the transmitter, its FIFO and the DMA.
+	dev->conf.tx_reset = 1;
+	dev->conf.tx_reset = 0;
+	dev->conf.tx_fifo_reset = 1;
+	dev->conf.tx_fifo_reset = 0;
+	dev->lc_conf.out_rst = 1;
+	dev->lc_conf.out_rst = 0;
+	dev->lc_conf.ahbm_rst = 1;
+	dev->lc_conf.ahbm_fifo_rst = 1;
+	dev->lc_conf.ahbm_rst = 0;
+	dev->lc_conf.ahbm_fifo_rst = 0;
+
+	// LCD mode: each 16 bit sample goes out in parallel on the data lines 8..23.
+	dev->conf2.val = 0;
+	dev->conf2.lcd_en = 1;
+	dev->sample_rate_conf.val = 0;
+	dev->sample_rate_conf.tx_bits_mod = 16;
+	dev->sample_rate_conf.tx_bck_div_num = 2;
+	dev->clkm_conf.val = 0;
+	dev->clkm_conf.clka_en = 0;   // PLL_D2 clock, 80 MHz.
+	dev->clkm_conf.clkm_div_a = 1;
+	dev->clkm_conf.clkm_div_b = 0;
+	dev->clkm_conf.clkm_div_num = div;
+	dev->fifo_conf.val = 0;
+	dev->fifo_conf.tx_fifo_mod_force_en = 1;
+	dev->fifo_conf.tx_fifo_mod = 1;   // 16 bit samples, one channel.
+	dev->fifo_conf.tx_data_num = 32;
+	dev->fifo_conf.dscr_en = 1;
+	dev->conf1.val = 0;
+	dev->conf1.tx_pcm_bypass = 1;
+	dev->conf_chan.val = 0;
+	dev->conf_chan.tx_chan_mod = 1;
+	dev->timing.val = 0;
+	dev->lc_conf.val = 0;
+	dev->lc_conf.out_eof_mode = 1;
+	dev->lc_conf.outdscr_burst_en = 1;
+	dev->lc_conf.out_data_burst_en = 1;
+
+	const unsigned signal = port == 0 ? I2S0O_DATA_OUT8_IDX : I2S1O_DATA_OUT8_IDX;
+	for( unsigned n = 0; n < count; n++ ) {
+		pinMode( pin[n], OUTPUT );
+		esp_rom_gpio_connect_out_signal( pin[n], signal + n, false, false );
+	}
+
+	if( (rc = esp_intr_alloc( port == 0 ? ETS_I2S0_INTR_SOURCE : ETS_I2S1_INTR_SOURCE, ESP_INTR_FLAG_IRAM,
+	                          on_eof, this, &interrupt )) != ESP_OK ) {
+		interrupt = nullptr;
+		release();
+		return rc;
+	}
+	dev->int_clr.val = ~0u;
+	dev->int_ena.out_eof = 1;
+
+	dev->out_link.addr = (uint32_t) (uintptr_t) &desc[0];
+	dev->out_link.start = 1;
+	dev->conf.tx_start = 1;
+
+	ESP_LOGI( TAG, "I2S%d stream: %u LEDs, %u Hz, %u samples per buffer", port, count, sample_rate, GLED_I2S_BUFFER_SAMPLES );
+	return ESP_OK;
+#else
+	ESP_LOGE( TAG, "the I2S stream needs an ESP32" );
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void GLedI2S::end()
+{
+	release();
+}
+
+void GLedI2S::release()
+{
+#if CONFIG_IDF_TARGET_ESP32
+	i2s_dev_t * dev = port == 0 ? &I2S0 : &I2S1;
+
+	if( interrupt != nullptr ) {
+		dev->int_ena.val = 0;
+		esp_intr_free( interrupt );
+		interrupt = nullptr;
+	}
+	if( running ) {
+		dev->conf.tx_start = 0;
+		dev->out_link.stop = 1;
+		periph_module_disable( port == 0 ? PERIPH_I2S0_MODULE : PERIPH_I2S1_MODULE );
+		for( unsigned n = 0; n < count; n++ ) {
+			digitalWrite( pin[n], LOW );
+			pinMode( pin[n], OUTPUT );   // route the gpio back from the I2S to the plain output.
+		}
+		running = false;
+	}
+#endif
+
+	const TaskHandle_t handle = task_handle;
+
+	if( handle != nullptr ) {
+		quit = true;
+		xTaskNotifyGive( handle );
+		while( task_handle != nullptr )
+			vTaskDelay( 1 );
+	}
+	for( int i = 0; i < GLED_I2S_BUFFERS; i++ ) {
+		if( buffer[i] != nullptr ) {
+			heap_caps_free( buffer[i] );
+			buffer[i] = nullptr;
+		}
+	}
+	if( descriptors != nullptr ) {
+		heap_caps_free( descriptors );
+		descriptors = nullptr;
+	}
+}
+
+esp_err_t GLedI2S::attach( unsigned channel )
+{
+	return channel < count ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void GLedI2S::set_level( unsigned channel, bool level )
+{
+	const uint32_t bit = 1u << channel;
+
+	request[channel] = nullptr;   // ends play().
+	if( level )
+		steady.fetch_or( bit );
+	else
+		steady.fetch_and( ~bit );
+	changed.fetch_or( bit );
+}
+
+void GLedI2S::write( unsigned channel, bool level )
+{
+	if( channel < count )
+		set_level( channel, level );
+}
+
+void IRAM_ATTR GLedI2S::write_from_isr( unsigned channel, bool level )
+{
+	if( channel < count )
+		set_level( channel, level );
+}
+
+esp_err_t GLedI2S::play( unsigned channel, const GLedPattern & pattern, uint64_t a_count, unsigned scale_us )
+{
+	if( channel >= count )
+		return ESP_ERR_INVALID_ARG;
+	if( a_count == 0 ) {
+		set_level( channel, false );
+		return ESP_OK;
+	}
+
+	// the render task skips intervals shorter than a sample, at least one has to be left.
+	if( period_samples( pattern, scale_us ) == 0 )
+		return ESP_ERR_INVALID_ARG;
+
+	request_t * r = claim_request( channel );
+	if( r == nullptr )   // overtaken by other writers.
+		return ESP_ERR_INVALID_STATE;
+
+	// the render task sees the request complete or not at all:
+	const uint32_t bit = 1u << channel;
+	r->pattern = &pattern;
+	r->count = a_count;
+	r->scale_us = scale_us;
+	request[channel] = r;
+	request_claims[channel].fetch_and( (uint8_t) ~(1u << (r - requests[channel])) );
+	steady.fetch_and( ~bit );   // dark after the last repetition.
+	changed.fetch_or( bit );
+	return ESP_OK;
+}
+
+// claim a request of a LED for play(), one which is neither published, nor read by the
+// render task, nor filled by another writer. Returns nullptr if all are in use.
+GLedI2S::request_t * GLedI2S::claim_request( unsigned channel )
+{
+	for( unsigned i = 0; i < REQUESTS; i++ ) {
+		const uint8_t bit = 1u << i;
+
+		if( request_claims[channel].fetch_or( bit ) & bit )
+			continue;
+		// only the owner of the claim publishes the request,
+		// so the request stays free once checked, see protect_request():
+		if( request[channel] != &requests[channel][i] && request_hazard != &requests[channel][i] )
+			return &requests[channel][i];
+		request_claims[channel].fetch_and( (uint8_t) ~bit );
+	}
+	return nullptr;
+}
+
+// get the published request of a LED for the render task and protect it against the writers
+// until the hazard is cleared: a writer which checked the hazard before sees the request changed.
+const GLedI2S::request_t * GLedI2S::protect_request( unsigned channel )
+{
+	const request_t * r = request[channel];
+
+	for(;;) {
+		request_hazard = r;
+		const request_t * current = request[channel];
+		if( current == r )
+			return r;
+		r = current;
+	}
+}
+
+uint32_t GLedI2S::samples( const player_t & p ) const
+{
+	return (uint32_t) (((uint64_t) p.pattern->duration( p.index ) * p.scale_us * sample_rate + 500000) / 1000000);
+}
+
+// samples of a whole period at the current rate, 0 if all intervals are shorter than a sample.
+uint32_t GLedI2S::period_samples( const GLedPattern & pattern, unsigned scale_us ) const
+{
+	player_t p = { &pattern, 0, scale_us, 0, 0 };
+	uint32_t total = 0;
+
+	for( p.index = 0; p.index < pattern.size(); p.index++ )
+		total += samples( p );
+	return total;
+}
+
+void GLedI2S::render( uint16_t * out )
+{
+	// take the requests made since the last buffer:
+	for( uint32_t c = changed.exchange( 0 ); c != 0; c &= c - 1 ) {
+		player_t & p = player[__builtin_ctz( c )];
+		const request_t * r = protect_request( __builtin_ctz( c ) );
+
+		p.pattern = nullptr;
+		p.index = 0;
+		// the rate may have changed since play(), a pattern without samples would never end:
+		if( r != nullptr && period_samples( *r->pattern, r->scale_us ) > 0 ) {
+			p.pattern = r->pattern;
+			p.count = r->count;
+			p.scale_us = r->scale_us;
+			p.left = samples( p );
+		}
+		request_hazard = nullptr;
+	}
+
+	uint32_t level = steady.load();
+	uint32_t playing = 0;
+	for( unsigned n = 0; n < count; n++ ) {
+		if( player[n].pattern != nullptr ) {
+			playing |= 1u << n;
+			level = GLedPattern::level( player[n].index ) ? level | (1u << n) : level & ~(1u << n);
+		}
+	}
+
+	// fill the runs between the edges of all LEDs:
+	unsigned pos = 0;
+	while( pos < GLED_I2S_BUFFER_SAMPLES ) {
+		uint32_t run = GLED_I2S_BUFFER_SAMPLES - pos;
+		for( uint32_t b = playing; b != 0; b &= b - 1 )
+			if( player[__builtin_ctz( b )].left < run )
+				run = player[__builtin_ctz( b )].left;
+
+		// the I2S sends the second 16 bit half of a 32 bit word first.
+		for( unsigned i = pos; i < pos + run; i++ )
+			out[i ^ 1] = (uint16_t) level;
+		pos += run;
+
+		for( uint32_t b = playing; b != 0; b &= b - 1 ) {
+			const unsigned n = __builtin_ctz( b );
+			player_t & p = player[n];
+
+			p.left -= run;
+			while( p.left == 0 && p.pattern != nullptr ) {   // intervals shorter than a sample are skipped.
+				if( ++p.index >= p.pattern->size() ) {
+					p.index = 0;
+					if( p.count != GLed::FLASH_FOR_EVER && --p.count == 0 ) {
+						p.pattern = nullptr;
+						playing &= ~(1u << n);
+						level = (level & ~(1u << n)) | (steady.load() & (1u << n));
+						break;
+					}
+				}
+				p.left = samples( p );
+			}
+			if( p.pattern != nullptr )
+				level = GLedPattern::level( p.index ) ? level | (1u << n) : level & ~(1u << n);
+		}
+	}
+}
+
+void IRAM_ATTR GLedI2S::on_eof( void *arg )
+{
+#if CONFIG_IDF_TARGET_ESP32
+	GLedI2S * pStream = (GLedI2S*) arg;
+	i2s_dev_t * dev = pStream->port == 0 ? &I2S0 : &I2S1;
+	const uint32_t status = dev->int_st.val;
+	BaseType_t task_woken = pdFALSE;
+
+	dev->int_clr.val = status;
+	if( (status & I2S_OUT_EOF_INT_ST) && pStream->task_handle != nullptr )
+		vTaskNotifyGiveFromISR( pStream->task_handle, &task_woken );
+	if( task_woken == pdTRUE )
+		portYIELD_FROM_ISR();
+#endif
+}
+
+void task_gled_i2s( void *pvParameters )
+{
+	GLedI2S * pStream = (GLedI2S*) pvParameters;
+
+	while( ! pStream->quit ) {
+		// one notification for each buffer sent:
+		uint32_t sent = ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		// the buffer being sent must not be touched, the ones before were sent again:
+		// go on with the buffer sent after it.
+		if( sent > GLED_I2S_BUFFERS - 1 ) {
+			const uint32_t dropped = sent - (GLED_I2S_BUFFERS - 1);
+			pStream->underruns += dropped;
+			pStream->next = (pStream->next + dropped) % GLED_I2S_BUFFERS;
+			sent = GLED_I2S_BUFFERS - 1;
+		}
+		for( ; sent > 0 && ! pStream->quit; sent-- ) {
+			pStream->render( (uint16_t*) pStream->buffer[pStream->next] );
+			pStream->next = (pStream->next + 1) % GLED_I2S_BUFFERS;
+			pStream->buffers++;
+		}
+	}
+
+	pStream->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+// eof
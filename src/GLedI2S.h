@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       waveforms of up to 16 LEDs streamed by the I2S parallel mode DMA.
+// premises:	   ESP32 (the I2S LCD mode of the other variants differs).
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedI2S.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_I2S_HEADER_H
+#define GLED_I2S_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_intr_alloc.h>
+
+#include "GLed.h"
+#include "GLedBackend.h"
+#include "GLedPattern.h"
+
+// number of LEDs of a stream, one bit of a 16 bit sample each.
+#define GLED_I2S_MAX_CHANNELS 16
+// DMA buffers in the ring and samples per buffer. A change shows up at most
+// (GLED_I2S_BUFFERS - 1) * GLED_I2S_BUFFER_SAMPLES samples later.
+#ifndef GLED_I2S_BUFFERS
+#define GLED_I2S_BUFFERS 4
+#endif
+#ifndef GLED_I2S_BUFFER_SAMPLES
+#define GLED_I2S_BUFFER_SAMPLES 1000
+#endif
+
+/**
+ * The GLedI2S drives up to 16 LEDs by the I2S peripheral in LCD (parallel) mode.
+ * Each output sample has one bit per LED, the DMA streams the samples from a ring of
+ * GLED_I2S_BUFFERS buffers at a fixed sample rate, 1 MHz by default.
+ * Whenever the DMA has sent a buffer, a render task refills it with the next samples,
+ * so the CPU works once per buffer and not per edge.
+ * \n
+ * A LED may play a GLedPattern at sample resolution with play(), with its times scaled from ms
+ * down to us, for ex. a 3 us pulse every 10 us is set_flash( 3, 7 ) played with scale_us = 1.
+ * All LEDs of the stream are rendered from one sample clock, so their waveforms keep their
+ * phase to each other for ever. A GLed of the stream works the usual way,
+ * its write() sets a steady level and ends play().
+ * \n
+ * The buffers take GLED_I2S_BUFFERS * GLED_I2S_BUFFER_SAMPLES * 2 bytes of DMA memory.
+ * \n
+ * Example, 16 LEDs of a test fixture:
+ * \code
+ * const int pins[] = { 13, 12, 14, 27, 26, 25, 33, 32, 15, 2, 4, 16, 17, 5, 18, 19 };
+ * GLedI2S stream( pins, 16 );
+ * GLedPattern burst;
+ *
+ * burst.set_flash( 2, 3 );         // 2 us on, 3 us off,
+ * burst.add_flash( 2, 43 );        // 2 us on, 43 us off.
+ * stream.begin();
+ * stream.play( 0, burst, GLed::FLASH_FOR_EVER, 1 );
+ * \endcode
+ */
+class GLedI2S : public GLedBackend {
+public:
+    static const unsigned DEFAULT_SAMPLE_RATE = 1000000;   ///< default output sample rate [Hz]
+
+    /**
+     * @param pins: gpio numbers, channel n of the stream is pins[n].
+     * @param count: number of pins, at most GLED_I2S_MAX_CHANNELS.
+     * @param port: I2S peripheral, 0 or 1.
+     */
+    GLedI2S( const int *pins, unsigned count, int port = 0 );
+
+    ~GLedI2S();
+
+    /**
+     * allocate the DMA buffers, route the pins to the I2S and start the stream and the render task.
+     * All LEDs are dark unless they have been written before.
+     * @param sample_rate: output samples per second, the rate is rounded to a divider of 80 MHz.
+     * @param core: core to run the render task.
+     * @return ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_NOT_SUPPORTED on variants other than the ESP32,
+     *         or the error code of the interrupt allocation.
+     */
+    esp_err_t begin( unsigned sample_rate = DEFAULT_SAMPLE_RATE, int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the stream and the render task and release the buffers. The pins are set LOW.
+     */
+    void end();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+
+    /**
+     * play a pattern on a LED at sample resolution. It starts with the next rendered buffer.
+     * The pattern is not copied, it has to stay unchanged while it is played.
+     * The LED is dark after the last repetition.
+     * @param channel: LED of the stream.
+     * @param pattern: on/off intervals.
+     * @param count: number of repetitions, GLed::FLASH_FOR_EVER for an endless sequence.
+     * @param scale_us: duration of a ms of the pattern (us), 1000 plays it in real time.
+     * @return ESP_OK, ESP_ERR_INVALID_ARG for an empty pattern or one shorter than a sample,
+     *         or ESP_ERR_INVALID_STATE if overtaken by other play() calls for the same LED.
+     *         A pattern shorter than a sample at the rate of a later begin() is not played, the LED is dark.
+     */
+    esp_err_t play( unsigned channel, const GLedPattern & pattern, uint64_t count = GLed::FLASH_FOR_EVER, unsigned scale_us = 1000 );
+
+    /**
+     * get the actual sample rate, which may differ a little from the one asked for.
+     */
+    unsigned get_sample_rate() const { return sample_rate; }
+
+    /**
+     * get the number of buffers rendered since begin().
+     */
+    uint32_t get_buffers() const { return buffers; }
+
+    /**
+     * get the number of buffers the render task was too late for, the DMA sent their old samples again.
+     */
+    uint32_t get_underruns() const { return underruns; }
+
+private:
+    typedef struct {
+        const GLedPattern * pattern;   ///< nullptr if the LED has a steady level.
+        uint64_t count;                ///< repetitions left.
+        unsigned scale_us;
+    } request_t;
+
+    typedef struct {
+        const GLedPattern * pattern;   ///< nullptr if the LED has a steady level.
+        uint64_t count;
+        unsigned scale_us;
+        unsigned index;                ///< interval played.
+        uint32_t left;                 ///< samples left in the interval.
+    } player_t;
+
+    int pin[GLED_I2S_MAX_CHANNELS];
+    unsigned count;
+    int port;
+    unsigned sample_rate;
+    void * buffer[GLED_I2S_BUFFERS];   ///< 16 bit samples, DMA capable.
+    void * descriptors;                ///< lldesc_t ring, DMA capable.
+    intr_handle_t interrupt;
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    bool running;
+
+    // A LED has REQUESTS requests: the one published, one the render task may still read and one for play().
+    static const unsigned REQUESTS = 3;
+
+    request_t requests[GLED_I2S_MAX_CHANNELS][REQUESTS];             ///< filled by play(), see claim_request().
+    std::atomic<request_t *> request[GLED_I2S_MAX_CHANNELS];         ///< published request, nullptr for a steady level.
+    std::atomic<uint8_t> request_claims[GLED_I2S_MAX_CHANNELS];      ///< bit n: play() fills requests[channel][n].
+    std::atomic<const request_t *> request_hazard;                   ///< request read by the render task.
+    std::atomic<uint32_t> steady;               ///< level of a LED without a pattern is bit n.
+    std::atomic<uint32_t> changed;              ///< LEDs with a new request or level.
+    player_t player[GLED_I2S_MAX_CHANNELS];     ///< used by the render task only.
+    unsigned next;                              ///< buffer to be rendered next.
+    std::atomic<uint32_t> buffers;
+    std::atomic<uint32_t> underruns;
+
+    void set_level( unsigned channel, bool level );
+    request_t * claim_request( unsigned channel );
+    const request_t * protect_request( unsigned channel );
+    uint32_t samples( const player_t & p ) const;
+    uint32_t period_samples( const GLedPattern & pattern, unsigned scale_us ) const;
+    void render( uint16_t * samples );
+    void release();
+    static void IRAM_ATTR on_eof( void *arg );
+
+friend
+    void task_gled_i2s( void *pvParameters );
+};
+
+#endif
+
+// eof
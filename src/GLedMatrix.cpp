@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs of a multiplexed matrix scanned by a timer.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMatrix.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedMatrix.h"
+
+static const char* TAG = "GLED";
+
+GLedMatrix::GLedMatrix( const int *row_pins, unsigned a_rows, const int *column_pins, unsigned a_columns,
+                        bool a_row_active_high, bool a_column_active_high )
+	: row_pin()
+	, column_pin()
+	, rows(a_rows < GLED_MATRIX_MAX_ROWS ? a_rows : GLED_MATRIX_MAX_ROWS)
+	, columns(a_columns < GLED_MATRIX_MAX_COLUMNS ? a_columns : GLED_MATRIX_MAX_COLUMNS)
+	, row_active_high(a_row_active_high)
+	, column_active_high(a_column_active_high)
+	, timer(nullptr)
+	, cell()
+	, version()
+	, shown()
+	, building()
+	, scanning(-1)
+	, scan_row(0)
+	, scan_slice(0)
+{
+	for( unsigned r = 0; r < rows; r++ )
+		row_pin[r] = row_pins[r];
+	for( unsigned c = 0; c < columns; c++ )
+		column_pin[c] = column_pins[c];
+}
+
+GLedMatrix::~GLedMatrix()
+{
+	end();
+}
+
+esp_err_t GLedMatrix::begin( unsigned refresh_hz )
+{
+	esp_err_t rc;
+
+	if( timer != nullptr )
+		return ESP_OK;
+
+	for( unsigned r = 0; r < rows; r++ ) {
+		row_on[r].clear();
+		row_on[r].add( row_pin[r], row_active_high );
+		row_off[r].clear();
+		row_off[r].add( row_pin[r], ! row_active_high );
+		row_off[r].write();
+		pinMode( row_pin[r], OUTPUT );
+		build_row( r );
+	}
+	for( unsigned c = 0; c < columns; c++ ) {
+		digitalWrite( column_pin[c], column_active_high ? LOW : HIGH );
+		pinMode( column_pin[c], OUTPUT );
+	}
+
+	esp_timer_create_args_t timer_args = {};
+	timer_args.callback = on_timer;
+	timer_args.arg = this;
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+	timer_args.dispatch_method = ESP_TIMER_ISR;
+#else
+	timer_args.dispatch_method = ESP_TIMER_TASK;
+#endif
+	timer_args.name = "gled_matrix";
+	timer_args.skip_unhandled_events = true;
+	if( (rc = esp_timer_create( &timer_args, &timer )) != ESP_OK ) {
+		timer = nullptr;
+		return rc;
+	}
+
+	const uint64_t tick = 1000000ull / ((uint64_t) (refresh_hz > 0 ? refresh_hz : 1) * rows * GLED_MATRIX_SLICES);
+	ESP_LOGI( TAG, "matrix %ux%u: %u Hz, tick %u us", rows, columns, refresh_hz, (unsigned) tick );
+
+	scan_row = 0;
+	scan_slice = 0;
+	return esp_timer_start_periodic( timer, tick > 0 ? tick : 1 );
+}
+
+void GLedMatrix::end()
+{
+	if( timer == nullptr )
+		return;
+
+	esp_timer_stop( timer );
+	esp_timer_delete( timer );
+	timer = nullptr;
+	for( unsigned r = 0; r < rows; r++ )
+		row_off[r].write();
+}
+
+esp_err_t GLedMatrix::attach( unsigned channel )
+{
+	return channel < rows * columns ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void GLedMatrix::write( unsigned channel, bool level )
+{
+	if( channel >= rows * columns )
+		return;
+
+	set_cell( channel, level ? GLED_MATRIX_SLICES : 0 );
+}
+
+void IRAM_ATTR GLedMatrix::write_from_isr( unsigned channel, bool level )
+{
+	if( channel >= rows * columns )
+		return;
+
+	if( cell[channel].exchange( level ? GLED_MATRIX_SLICES : 0 ) != (level ? GLED_MATRIX_SLICES : 0) ) {
+		const unsigned row = channel / columns;
+		version[row]++;
+		build_row( row );
+	}
+}
+
+esp_err_t GLedMatrix::set_brightness( unsigned channel, uint8_t duty )
+{
+	if( channel >= rows * columns )
+		return ESP_ERR_INVALID_ARG;
+
+	const uint8_t slices = (duty * GLED_MATRIX_SLICES + 127) / 255;
+	set_cell( channel, slices );
+	return ESP_OK;
+}
+
+void GLedMatrix::set_cell( unsigned channel, uint8_t slices )
+{
+	if( cell[channel].exchange( slices ) != slices ) {
+		const unsigned row = channel / columns;
+		version[row]++;
+		build_row( row );
+	}
+}
+
+void IRAM_ATTR GLedMatrix::build_row( unsigned row )
+{
+	// one builder per row, the others only count their change in version[row]:
+	// the builder at work builds the row again until it has seen the last version.
+	while( ! building[row].exchange( true ) ) {
+		uint32_t v;
+		do {
+			v = version[row];
+
+			// a frame neither shown nor read by the timer, see on_timer():
+			const unsigned current = shown[row];
+			const int hazard = scanning;
+			unsigned f = 0;
+			while( f == current || (int) (row * FRAMES + f) == hazard )
+				f++;
+
+			for( unsigned s = 0; s < GLED_MATRIX_SLICES; s++ ) {
+				GLedGpioMask mask;
+				for( unsigned c = 0; c < columns; c++ )
+					mask.add( column_pin[c], (cell[row * columns + c] > s) == column_active_high );
+				frame[row][f][s] = mask;
+			}
+			shown[row] = f;
+		} while( version[row] != v );
+
+		building[row] = false;
+		if( version[row] == v )   // no change was left to this builder meanwhile.
+			return;
+	}
+}
+
+void IRAM_ATTR GLedMatrix::on_timer( void *arg )
+{
+	GLedMatrix * m = (GLedMatrix*) arg;
+	const unsigned row = m->scan_row;
+	const unsigned slice = m->scan_slice;
+
+	// announce the frame before it is read, a builder fills another one meanwhile:
+	unsigned f = m->shown[row];
+	for(;;) {
+		m->scanning = row * FRAMES + f;
+		const unsigned current = m->shown[row];
+		if( current == f )
+			break;
+		f = current;
+	}
+
+	// no ghosting: the row is off while the columns change.
+	if( slice == 0 )
+		m->row_off[row == 0 ? m->rows - 1 : row - 1].write();
+	m->frame[row][f][slice].write();
+	m->scanning = -1;
+	if( slice == 0 )
+		m->row_on[row].write();
+
+	if( slice + 1 < GLED_MATRIX_SLICES )
+		m->scan_slice = slice + 1;
+	else {
+		m->scan_slice = 0;
+		m->scan_row = row + 1 < m->rows ? row + 1 : 0;
+	}
+}
+
+// eof
@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs of a multiplexed matrix scanned by a timer.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMatrix.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_MATRIX_HEADER_H
+#define GLED_MATRIX_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+
+#include "GLedBackend.h"
+#include "GLedGpio.h"
+
+#ifndef GLED_MATRIX_MAX_ROWS
+#define GLED_MATRIX_MAX_ROWS 16
+#endif
+#ifndef GLED_MATRIX_MAX_COLUMNS
+#define GLED_MATRIX_MAX_COLUMNS 16
+#endif
+// brightness steps of a cell: each row is shown for this number of timer ticks per refresh.
+#ifndef GLED_MATRIX_SLICES
+#define GLED_MATRIX_SLICES 4
+#endif
+
+/**
+ * The GLedMatrix drives the LEDs of a row/column multiplexed matrix, each cell is a GLed.
+ * A periodic timer shows one row after the other. Each row is shown for GLED_MATRIX_SLICES ticks,
+ * a cell is lit in as many slices as its brightness, so set_brightness() works with
+ * GLED_MATRIX_SLICES + 1 steps.
+ * \n
+ * The gpio masks of the columns are computed for each row and slice when a cell changes.
+ * The timer callback only writes three precomputed masks: the previous row off,
+ * the columns of the row and slice, the row on. It takes the same time for all cells.
+ * A changed row is built into a spare frame and then swapped in, so the timer never
+ * writes a half built mask.
+ * The timer runs in ISR context if the esp_timer supports it
+ * (CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD), otherwise in the esp_timer task.
+ * \n
+ * Example, 8x8 matrix with the anodes on the rows:
+ * \code
+ * const int rows[] = { 13, 12, 14, 27, 26, 25, 33, 32 };
+ * const int columns[] = { 15, 2, 4, 16, 17, 5, 18, 19 };
+ * GLedMatrix matrix( rows, 8, columns, 8 );
+ * GLed cell( matrix, matrix.channel( 2, 3 ) );
+ *
+ * matrix.begin();
+ * cell.begin();
+ * cell.async_flash();
+ * \endcode
+ */
+class GLedMatrix : public GLedBackend {
+public:
+    static const unsigned DEFAULT_REFRESH = 250;   ///< default refresh rate of the whole matrix [Hz]
+
+    /**
+     * @param row_pins: gpio numbers of the rows.
+     * @param rows: number of rows, at most GLED_MATRIX_MAX_ROWS.
+     * @param column_pins: gpio numbers of the columns.
+     * @param columns: number of columns, at most GLED_MATRIX_MAX_COLUMNS.
+     * @param row_active_high: a row is selected by a HIGH level (common anode rows).
+     * @param column_active_high: a cell of the selected row is lit by a HIGH level of its column.
+     */
+    GLedMatrix( const int *row_pins, unsigned rows, const int *column_pins, unsigned columns,
+                bool row_active_high = true, bool column_active_high = false );
+
+    ~GLedMatrix();
+
+    /**
+     * configure the gpios and start the scan timer.
+     * @param refresh_hz: refresh rate of the whole matrix.
+     * @return ESP_OK or the error code of the esp_timer.
+     */
+    esp_err_t begin( unsigned refresh_hz = DEFAULT_REFRESH );
+
+    /**
+     * stop the scan, all rows are switched off.
+     */
+    void end();
+
+    /**
+     * get the channel of a cell, to be used in the GLed constructor.
+     */
+    unsigned channel( unsigned row, unsigned column ) const { return row * columns + column; }
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+    esp_err_t set_brightness( unsigned channel, uint8_t duty ) override;
+
+private:
+    int row_pin[GLED_MATRIX_MAX_ROWS];
+    int column_pin[GLED_MATRIX_MAX_COLUMNS];
+    unsigned rows;
+    unsigned columns;
+    bool row_active_high;
+    bool column_active_high;
+    esp_timer_handle_t timer;
+
+    std::atomic<uint8_t> cell[GLED_MATRIX_MAX_ROWS * GLED_MATRIX_MAX_COLUMNS];   ///< slices a cell is lit.
+    std::atomic<uint32_t> version[GLED_MATRIX_MAX_ROWS];                        ///< changes of the cells of a row.
+
+    // scan tables, read by the timer callback.
+    // A row has FRAMES frames: the one shown, one the timer may still read and one for the builder.
+    static const unsigned FRAMES = 3;
+    GLedGpioMask row_on[GLED_MATRIX_MAX_ROWS];
+    GLedGpioMask row_off[GLED_MATRIX_MAX_ROWS];
+    GLedGpioMask frame[GLED_MATRIX_MAX_ROWS][FRAMES][GLED_MATRIX_SLICES];
+    std::atomic<uint8_t> shown[GLED_MATRIX_MAX_ROWS];      ///< frame of a row taken by the timer.
+    std::atomic<bool> building[GLED_MATRIX_MAX_ROWS];      ///< a builder fills a frame of the row.
+    std::atomic<int> scanning;                             ///< row * FRAMES + frame read by the timer, -1 if none.
+    unsigned scan_row;
+    unsigned scan_slice;
+
+    void set_cell( unsigned channel, uint8_t slices );
+    void IRAM_ATTR build_row( unsigned row );
+    static void IRAM_ATTR on_timer( void *arg );
+};
+
+#endif
+
+// eof
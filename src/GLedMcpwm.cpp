@@ -0,0 +1,278 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs blinking with fixed phase offsets, driven by one MCPWM timer.
+// premises:	   ESP32 or ESP32 variant with MCPWM, ESP-IDF 5.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMcpwm.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedMcpwm.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && SOC_MCPWM_SUPPORTED
+#define GLED_MCPWM 1
+#else
+#define GLED_MCPWM 0
+#endif
+
+GLedMcpwm::GLedMcpwm( const int *pins, unsigned a_count, int a_group )
+	: pin()
+	, count(a_count < GLED_MCPWM_MAX_CHANNELS ? a_count : GLED_MCPWM_MAX_CHANNELS)
+	, group(a_group)
+	, period_ticks(0)
+#if GLED_MCPWM
+	, timer(nullptr)
+	, oper()
+	, cmp_on()
+	, cmp_off()
+	, gen()
+	, next_force()
+#endif
+	, running(false)
+{
+	for( unsigned n = 0; n < count; n++ ) {
+		pin[n] = pins[n];
+#if GLED_MCPWM
+		next_force[n] = FORCE_NONE;
+#endif
+	}
+}
+
+GLedMcpwm::~GLedMcpwm()
+{
+	end();
+}
+
+#if GLED_MCPWM
+
+static const char* TAG = "GLED";
+
+// largest period of the 16 bit timer.
+static const uint32_t MAX_PERIOD_TICKS = 0xffff;
+
+esp_err_t GLedMcpwm::begin( uint32_t period_us )
+{
+	esp_err_t rc;
+
+	if( running )
+		return ESP_OK;
+
+	// the slower the timer clock, the longer the period which fits into the timer.
+	uint32_t resolution = GLED_MCPWM_RESOLUTION;
+	if( (uint64_t) period_us * resolution / 1000000 > MAX_PERIOD_TICKS )
+		resolution = (uint32_t) ((uint64_t) MAX_PERIOD_TICKS * 1000000 / (period_us > 0 ? period_us : 1));
+	period_ticks = (uint32_t) ((uint64_t) period_us * resolution / 1000000);
+	if( period_ticks < 2 )
+		return ESP_ERR_INVALID_ARG;
+
+	mcpwm_timer_config_t timer_config = {};
+	timer_config.group_id = group;
+	timer_config.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+	timer_config.resolution_hz = resolution;
+	timer_config.count_mode = MCPWM_TIMER_COUNT_MODE_UP;
+	timer_config.period_ticks = period_ticks;
+	if( (rc = mcpwm_new_timer( &timer_config, &timer )) != ESP_OK ) {
+		timer = nullptr;
+		ESP_LOGE( TAG, "MCPWM group %d: a period of %u us can not be set", group, (unsigned) period_us );
+		return rc;
+	}
+
+	// set_phase() and the steady levels take effect at the end of a period:
+	mcpwm_timer_event_callbacks_t callbacks = {};
+	callbacks.on_empty = on_empty;
+	if( (rc = mcpwm_timer_register_event_callbacks( timer, &callbacks, this )) != ESP_OK ) {
+		release();
+		return rc;
+	}
+
+	for( unsigned n = 0; n < count; n++ ) {
+		if( (rc = install( n )) != ESP_OK ) {
+			release();
+			return rc;
+		}
+	}
+
+	if( (rc = mcpwm_timer_enable( timer )) != ESP_OK ) {
+		release();
+		return rc;
+	}
+	running = true;
+	if( (rc = mcpwm_timer_start_stop( timer, MCPWM_TIMER_START_NO_STOP )) != ESP_OK ) {
+		release();
+		return rc;
+	}
+
+	ESP_LOGI( TAG, "MCPWM group %d: %u LEDs, period %u ticks of %u Hz", group, count, (unsigned) period_ticks, (unsigned) resolution );
+	return ESP_OK;
+}
+
+esp_err_t GLedMcpwm::install( unsigned n )
+{
+	esp_err_t rc;
+
+	mcpwm_operator_config_t oper_config = {};
+	oper_config.group_id = group;
+	if( (rc = mcpwm_new_operator( &oper_config, &oper[n] )) != ESP_OK ) {
+		oper[n] = nullptr;
+		return rc;
+	}
+	if( (rc = mcpwm_operator_connect_timer( oper[n], timer )) != ESP_OK )
+		return rc;
+
+	// the compare values are taken over when the timer is zero, at the end of a period.
+	mcpwm_comparator_config_t cmp_config = {};
+	cmp_config.flags.update_cmp_on_tez = true;
+	if( (rc = mcpwm_new_comparator( oper[n], &cmp_config, &cmp_on[n] )) != ESP_OK ) {
+		cmp_on[n] = nullptr;
+		return rc;
+	}
+	if( (rc = mcpwm_new_comparator( oper[n], &cmp_config, &cmp_off[n] )) != ESP_OK ) {
+		cmp_off[n] = nullptr;
+		return rc;
+	}
+
+	mcpwm_generator_config_t gen_config = {};
+	gen_config.gen_gpio_num = pin[n];
+	if( (rc = mcpwm_new_generator( oper[n], &gen_config, &gen[n] )) != ESP_OK ) {
+		gen[n] = nullptr;
+		return rc;
+	}
+
+	// no action at the end of the period, so a pulse may run across it.
+	if( (rc = mcpwm_generator_set_action_on_compare_event( gen[n],
+			MCPWM_GEN_COMPARE_EVENT_ACTION( MCPWM_TIMER_DIRECTION_UP, cmp_on[n], MCPWM_GEN_ACTION_HIGH ) )) != ESP_OK )
+		return rc;
+	if( (rc = mcpwm_generator_set_action_on_compare_event( gen[n],
+			MCPWM_GEN_COMPARE_EVENT_ACTION( MCPWM_TIMER_DIRECTION_UP, cmp_off[n], MCPWM_GEN_ACTION_LOW ) )) != ESP_OK )
+		return rc;
+
+	next_force[n] = FORCE_NONE;
+	return mcpwm_generator_set_force_level( gen[n], 0, true );   // dark until set_phase().
+}
+
+void GLedMcpwm::release()
+{
+	if( running ) {
+		mcpwm_timer_start_stop( timer, MCPWM_TIMER_STOP_EMPTY );
+		mcpwm_timer_disable( timer );
+	}
+	for( unsigned n = 0; n < count; n++ ) {
+		if( gen[n] != nullptr ) {
+			mcpwm_del_generator( gen[n] );
+			gen[n] = nullptr;
+			digitalWrite( pin[n], LOW );
+			pinMode( pin[n], OUTPUT );   // route the gpio back from the MCPWM to the plain output.
+		}
+		if( cmp_on[n] != nullptr ) {
+			mcpwm_del_comparator( cmp_on[n] );
+			cmp_on[n] = nullptr;
+		}
+		if( cmp_off[n] != nullptr ) {
+			mcpwm_del_comparator( cmp_off[n] );
+			cmp_off[n] = nullptr;
+		}
+		if( oper[n] != nullptr ) {
+			mcpwm_del_operator( oper[n] );
+			oper[n] = nullptr;
+		}
+	}
+	if( timer != nullptr ) {
+		mcpwm_del_timer( timer );
+		timer = nullptr;
+	}
+	running = false;
+}
+
+void GLedMcpwm::write( unsigned channel, bool level )
+{
+	if( channel < count && running ) {
+		next_force[channel] = level ? 1 : 0;   // drops a set_phase() not yet taken effect.
+		mcpwm_generator_set_force_level( gen[channel], level ? 1 : 0, true );
+	}
+}
+
+esp_err_t GLedMcpwm::set_phase( unsigned channel, unsigned phase_deg, uint8_t duty )
+{
+	esp_err_t rc;
+
+	if( channel >= count || phase_deg >= 360 )
+		return ESP_ERR_INVALID_ARG;
+	if( ! running )
+		return ESP_ERR_INVALID_STATE;
+
+	// on and off at the same tick would leave the level undefined.
+	if( duty == 0 || duty == 255 ) {
+		next_force[channel] = duty == 0 ? 0 : 1;
+		return ESP_OK;
+	}
+
+	const uint32_t on = (uint32_t) ((uint64_t) period_ticks * phase_deg / 360);
+	const uint32_t width = (uint32_t) ((uint64_t) period_ticks * duty / 255);
+	const uint32_t off = (on + (width > 0 ? width : 1)) % period_ticks;
+
+	if( (rc = mcpwm_comparator_set_compare_value( cmp_on[channel], on )) != ESP_OK )
+		return rc;
+	if( (rc = mcpwm_comparator_set_compare_value( cmp_off[channel], off )) != ESP_OK )
+		return rc;
+	next_force[channel] = FORCE_RELEASE;   // the comparators drive the pin from the next period on.
+	return ESP_OK;
+}
+
+// end of a period, the new compare values are taken over now: switch the steady levels as well.
+// A level set by write() meanwhile is forced again, which does not change the pin.
+bool IRAM_ATTR GLedMcpwm::on_empty( mcpwm_timer_handle_t, const mcpwm_timer_event_data_t *, void *arg )
+{
+	GLedMcpwm * pGroup = (GLedMcpwm*) arg;
+
+	for( unsigned n = 0; n < pGroup->count; n++ ) {
+		if( pGroup->next_force[n] == FORCE_NONE )
+			continue;
+		const int8_t level = pGroup->next_force[n].exchange( FORCE_NONE );
+		if( level != FORCE_NONE )
+			mcpwm_generator_set_force_level( pGroup->gen[n], level, true );
+	}
+	return false;
+}
+
+#else
+
+esp_err_t GLedMcpwm::begin( uint32_t ) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t GLedMcpwm::install( unsigned ) { return ESP_ERR_NOT_SUPPORTED; }
+void GLedMcpwm::release() { running = false; }
+void GLedMcpwm::write( unsigned, bool ) {}
+esp_err_t GLedMcpwm::set_phase( unsigned, unsigned, uint8_t ) { return ESP_ERR_NOT_SUPPORTED; }
+
+#endif
+
+void GLedMcpwm::end()
+{
+	release();
+}
+
+esp_err_t GLedMcpwm::attach( unsigned channel )
+{
+	return channel < count ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void IRAM_ATTR GLedMcpwm::write_from_isr( unsigned channel, bool level )
+{
+	// the force level is set by a register write (CONFIG_MCPWM_CTRL_FUNC_IN_IRAM for the flash cache).
+	write( channel, level );
+}
+
+// eof
@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs blinking with fixed phase offsets, driven by one MCPWM timer.
+// premises:	   ESP32 or ESP32 variant with MCPWM, ESP-IDF 5.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedMcpwm.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_MCPWM_HEADER_H
+#define GLED_MCPWM_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <soc/soc_caps.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && SOC_MCPWM_SUPPORTED
+#include <driver/mcpwm_prelude.h>
+#define GLED_MCPWM_MAX_CHANNELS SOC_MCPWM_OPERATORS_PER_GROUP
+#else
+#define GLED_MCPWM_MAX_CHANNELS 3
+#endif
+
+#include "GLedBackend.h"
+
+// timer clock, lowered by begin() if a period does not fit into the 16 bit timer.
+#ifndef GLED_MCPWM_RESOLUTION
+#define GLED_MCPWM_RESOLUTION 1000000
+#endif
+
+/**
+ * The GLedMcpwm lets up to 3 LEDs (one per MCPWM operator) blink with the same period
+ * and fixed phase offsets, for ex. a running light. All LEDs are driven by one timer of an MCPWM group,
+ * so they never drift apart and no CPU time is used while they blink.
+ * \n
+ * Each LED has two comparators: the output goes HIGH when the timer passes the phase
+ * and LOW when it passes phase + duty, also across the end of the period.
+ * set_phase() takes effect at the end of the current period, so it never cuts or stretches a pulse:
+ * the comparators are updated there, and the interrupt of the timer at the end of each period
+ * releases or sets the steady level. Keep the period well above the interrupt latency, a few 10 us.
+ * \n
+ * A GLed of the group switches the LED the usual way, write() forces a steady level
+ * and ends the blinking until the next set_phase().
+ * \n
+ * The longest period depends on the MCPWM clock prescalers of the chip and the ESP-IDF version,
+ * begin() returns the error of the MCPWM driver if it can not be reached.
+ * \n
+ * Example, a running light of 3 LEDs:
+ * \code
+ * const int pins[] = { 25, 26, 27 };
+ * GLedMcpwm group( pins, 3 );
+ * GLed first( group, 0 ), second( group, 1 ), third( group, 2 );
+ *
+ * group.begin( 150000 );
+ * first.begin();
+ * second.begin();
+ * third.begin();
+ * group.set_phase( 0, 0, 85 );     // each LED on for a third of the period.
+ * group.set_phase( 1, 120, 85 );
+ * group.set_phase( 2, 240, 85 );
+ * \endcode
+ */
+class GLedMcpwm : public GLedBackend {
+public:
+    /**
+     * @param pins: gpio numbers, channel n of the group is pins[n].
+     * @param count: number of pins, at most GLED_MCPWM_MAX_CHANNELS.
+     * @param group: MCPWM group, 0 or 1 on chips with two groups.
+     */
+    GLedMcpwm( const int *pins, unsigned count, int group = 0 );
+
+    ~GLedMcpwm();
+
+    /**
+     * install the timer, the operators and the generators and start the timer. All LEDs are dark.
+     * @param period_us: blink period (us).
+     * @return ESP_OK, ESP_ERR_NOT_SUPPORTED without MCPWM or ESP-IDF 5,
+     *         or the error code of the MCPWM driver.
+     */
+    esp_err_t begin( uint32_t period_us );
+
+    /**
+     * stop the timer and release the MCPWM resources. The pins are set LOW.
+     */
+    void end();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+
+    /**
+     * let a LED blink with the period of the group. A change takes effect at the end of the current period,
+     * also after a steady level of write().
+     * @param channel: LED of the group.
+     * @param phase_deg: start of the pulse within the period, 0..359 degrees.
+     * @param duty: width of the pulse, 0..255 for 0..100 % of the period.
+     *              As for GLedBackend::set_brightness(), the output is HIGH during the pulse.
+     * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_STATE before begin().
+     */
+    esp_err_t set_phase( unsigned channel, unsigned phase_deg, uint8_t duty );
+
+    /**
+     * get the period in timer ticks, which may be a little shorter than the period asked for.
+     */
+    uint32_t get_period_ticks() const { return period_ticks; }
+
+private:
+    int pin[GLED_MCPWM_MAX_CHANNELS];
+    unsigned count;
+    int group;
+    uint32_t period_ticks;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && SOC_MCPWM_SUPPORTED
+    mcpwm_timer_handle_t timer;
+    mcpwm_oper_handle_t oper[GLED_MCPWM_MAX_CHANNELS];
+    mcpwm_cmpr_handle_t cmp_on[GLED_MCPWM_MAX_CHANNELS];    ///< start of the pulse.
+    mcpwm_cmpr_handle_t cmp_off[GLED_MCPWM_MAX_CHANNELS];   ///< end of the pulse.
+    mcpwm_gen_handle_t gen[GLED_MCPWM_MAX_CHANNELS];
+    std::atomic<int8_t> next_force[GLED_MCPWM_MAX_CHANNELS];   ///< level to force at the end of the period, see on_empty().
+#endif
+    bool running;
+
+    static const int8_t FORCE_NONE = -2;      ///< next_force: nothing to change.
+    static const int8_t FORCE_RELEASE = -1;   ///< next_force: the comparators drive the pin.
+
+    esp_err_t install( unsigned channel );
+    void release();
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && SOC_MCPWM_SUPPORTED
+    static bool IRAM_ATTR on_empty( mcpwm_timer_handle_t timer, const mcpwm_timer_event_data_t *event, void *arg );
+#endif
+};
+
+#endif
+
+// eof
@@ -0,0 +1,311 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       dimmable LEDs on a PCA9685 16 channel PWM controller.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPCA9685.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedPCA9685.h"
+
+void task_gled_pca9685( void *pvParameters );
+
+static const char* TAG = "GLED";
+
+// registers and bits of the PCA9685:
+static const uint8_t MODE1 = 0x00;
+static const uint8_t MODE2 = 0x01;
+static const uint8_t LED0_ON_L = 0x06;
+static const uint8_t ALL_LED_ON_L = 0xfa;
+static const uint8_t PRE_SCALE = 0xfe;
+static const uint8_t MODE1_AI = 0x20;
+static const uint8_t MODE1_SLEEP = 0x10;
+static const uint8_t MODE2_OUTDRV = 0x04;
+static const uint16_t FULL = 0x1000;     // full on / full off bit of the ON_H / OFF_H register.
+static const int OSCILLATOR = 25000000;
+
+GLedPCA9685::GLedPCA9685( i2c_port_t a_port, uint8_t a_address, int a_frequency )
+	: port(a_port)
+	, address(a_address)
+	, frequency(a_frequency)
+	, bus_write(i2c_write)
+	, bus_ctx(this)
+	, channels()
+	, sent_valid(false)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transactions(0)
+	, errors(0)
+{
+}
+
+GLedPCA9685::GLedPCA9685( uint8_t a_address, gled_i2c_write_t a_bus_write, void *ctx, int a_frequency )
+	: port(0)
+	, address(a_address)
+	, frequency(a_frequency)
+	, bus_write(a_bus_write)
+	, bus_ctx(ctx)
+	, channels()
+	, sent_valid(false)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transactions(0)
+	, errors(0)
+{
+}
+
+GLedPCA9685::~GLedPCA9685()
+{
+	end();
+}
+
+esp_err_t GLedPCA9685::begin( int core_num )
+{
+	esp_err_t rc;
+
+	if( task_handle != nullptr )
+		return ESP_OK;
+
+	int prescale = (OSCILLATOR + 2048 * frequency) / (4096 * frequency) - 1;
+	prescale = prescale < 3 ? 3 : prescale > 255 ? 255 : prescale;
+
+	// the prescaler can only be set in sleep mode, the oscillator needs 500 us to wake up:
+	const uint8_t sleep[] = { MODE1, MODE1_SLEEP | MODE1_AI };
+	const uint8_t pre_scale[] = { PRE_SCALE, (uint8_t) prescale };
+	const uint8_t wake[] = { MODE1, MODE1_AI };
+	const uint8_t mode2[] = { MODE2, MODE2_OUTDRV };
+	const uint8_t all_off[] = { ALL_LED_ON_L, 0, 0, 0, FULL >> 8 };
+
+	if( (rc = write_bytes( sleep, sizeof(sleep) )) != ESP_OK
+	 || (rc = write_bytes( pre_scale, sizeof(pre_scale) )) != ESP_OK
+	 || (rc = write_bytes( wake, sizeof(wake) )) != ESP_OK )
+		return rc;
+	delay( 1 );
+	if( (rc = write_bytes( mode2, sizeof(mode2) )) != ESP_OK
+	 || (rc = write_bytes( all_off, sizeof(all_off) )) != ESP_OK )
+		return rc;
+
+	for( unsigned i = 0; i < OUTPUTS; i++ )
+		channels[i].sent = 0;
+	sent_valid = true;
+
+	ESP_LOGI( TAG, "PCA9685 (0x%02x) started: prescale=%d", address, prescale );
+
+	quit = false;
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_pca9685, "task_gled_pca9685", 2048, this, 1, & handle, core_num ) != pdPASS )
+		return ESP_ERR_NO_MEM;
+	task_handle = handle;
+	if( dirty )
+		xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+void GLedPCA9685::end()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( handle == nullptr )
+		return;
+
+	quit = true;
+	xTaskNotifyGive( handle );
+	while( task_handle != nullptr )
+		vTaskDelay( 1 );
+}
+
+esp_err_t GLedPCA9685::attach( unsigned channel )
+{
+	return channel < OUTPUTS ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void GLedPCA9685::wake()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( ! dirty.exchange( true ) && handle != nullptr )
+		xTaskNotifyGive( handle );
+}
+
+void GLedPCA9685::write( unsigned channel, bool level )
+{
+	if( channel >= OUTPUTS )
+		return;
+
+	channel_t & c = channels[channel];
+	const uint16_t duty = level ? MAX_DUTY : 0;
+	const bool was_fading = c.fading.exchange( false );
+
+	if( c.duty.exchange( duty ) != duty || was_fading )
+		wake();
+}
+
+void IRAM_ATTR GLedPCA9685::write_from_isr( unsigned channel, bool level )
+{
+	if( channel >= OUTPUTS )
+		return;
+
+	channel_t & c = channels[channel];
+	const uint16_t duty = level ? MAX_DUTY : 0;
+	const bool was_fading = c.fading.exchange( false );
+	const TaskHandle_t handle = task_handle;
+
+	if( (c.duty.exchange( duty ) != duty || was_fading) && ! dirty.exchange( true ) && handle != nullptr )
+		vTaskNotifyGiveFromISR( handle, nullptr );
+}
+
+esp_err_t GLedPCA9685::set_brightness( unsigned channel, uint8_t duty )
+{
+	if( channel >= OUTPUTS )
+		return ESP_ERR_INVALID_ARG;
+
+	channels[channel].fading = false;
+	channels[channel].duty = scale( duty );
+	wake();
+	return ESP_OK;
+}
+
+esp_err_t GLedPCA9685::breathe( unsigned channel, unsigned period_ms, uint8_t from, uint8_t to )
+{
+	if( channel >= OUTPUTS )
+		return ESP_ERR_INVALID_ARG;
+
+	channel_t & c = channels[channel];
+	const TickType_t period = pdMS_TO_TICKS( period_ms );
+
+	c.fading = false;   // the frame task ignores the fade values while they change.
+	c.fade_period = period > 2 ? period : 2;
+	c.fade_from = scale( from );
+	c.fade_to = scale( to );
+	c.fade_start = xTaskGetTickCount();
+	c.fading = true;
+	wake();
+	return ESP_OK;
+}
+
+uint16_t GLedPCA9685::frame_duty( const channel_t & c, TickType_t now ) const
+{
+	if( ! c.fading )
+		return c.duty;
+
+	// triangle: from -> to in the first half of the period, back in the second half.
+	const TickType_t half = c.fade_period / 2;
+	const TickType_t phase = (now - c.fade_start) % c.fade_period;
+	const TickType_t x = phase < half ? phase : c.fade_period - phase;
+	return c.fade_from + ((int) c.fade_to - (int) c.fade_from) * (int) x / (int) half;
+}
+
+bool GLedPCA9685::is_fading() const
+{
+	for( unsigned i = 0; i < OUTPUTS; i++ )
+		if( channels[i].fading )
+			return true;
+	return false;
+}
+
+esp_err_t GLedPCA9685::flush()
+{
+	uint16_t duty[OUTPUTS];
+	uint8_t data[1 + 4 * OUTPUTS];
+	int first = -1;
+	int last = -1;
+	const TickType_t now = xTaskGetTickCount();
+
+	dirty = false;   // changes from now on get into the next frame.
+	for( unsigned i = 0; i < OUTPUTS; i++ ) {
+		duty[i] = frame_duty( channels[i], now );
+		if( ! sent_valid || duty[i] != channels[i].sent ) {
+			if( first < 0 )
+				first = i;
+			last = i;
+		}
+	}
+	if( first < 0 )
+		return ESP_OK;
+
+	// one auto increment burst from the first to the last changed channel:
+	size_t n = 0;
+	data[n++] = LED0_ON_L + 4 * first;
+	for( int i = first; i <= last; i++ ) {
+		uint16_t on = i * (MAX_DUTY / OUTPUTS);   // staggered start of the on time.
+		uint16_t off;
+
+		if( duty[i] == 0 ) {
+			on = 0;
+			off = FULL;
+		}
+		else if( duty[i] >= MAX_DUTY ) {
+			on = FULL;
+			off = 0;
+		}
+		else
+			off = (on + duty[i]) & (MAX_DUTY - 1);
+
+		data[n++] = on & 0xff;
+		data[n++] = on >> 8;
+		data[n++] = off & 0xff;
+		data[n++] = off >> 8;
+	}
+
+	const esp_err_t rc = write_bytes( data, n );
+	if( rc != ESP_OK ) {
+		dirty = true;   // the frame task retries, a change does not notify it while dirty.
+		return rc;
+	}
+	for( int i = first; i <= last; i++ )
+		channels[i].sent = duty[i];
+	sent_valid = true;
+	return ESP_OK;
+}
+
+esp_err_t GLedPCA9685::write_bytes( const uint8_t *data, size_t len )
+{
+	transactions++;
+	const esp_err_t rc = bus_write( bus_ctx, address, data, len );
+	if( rc != ESP_OK )
+		errors++;
+	return rc;
+}
+
+esp_err_t GLedPCA9685::i2c_write( void *ctx, uint8_t address, const uint8_t *data, size_t len )
+{
+	return i2c_master_write_to_device( ((GLedPCA9685*) ctx)->port, address, data, len, pdMS_TO_TICKS( I2C_TIMEOUT ) );
+}
+
+void task_gled_pca9685( void *pvParameters )
+{
+	GLedPCA9685 * pDevice = (GLedPCA9685*) pvParameters;
+	bool sent = true;
+
+	while( ! pDevice->quit ) {
+		// a fading channel needs a frame each GLED_PCA9685_FRAME_TIME, else only changes are sent.
+		// After a bus error the changes stay pending, the changes meanwhile do not notify:
+		ulTaskNotifyTake( pdTRUE, pDevice->is_fading() ? pdMS_TO_TICKS( GLED_PCA9685_FRAME_TIME )
+								  : sent ? portMAX_DELAY : pdMS_TO_TICKS( GLED_PCA9685_RETRY_MS ) );
+		sent = pDevice->flush() == ESP_OK;
+	}
+	pDevice->flush();
+
+	pDevice->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+// eof
@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       dimmable LEDs on a PCA9685 16 channel PWM controller.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPCA9685.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_PCA9685_HEADER_H
+#define GLED_PCA9685_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/i2c.h>
+
+#include "GLed.h"
+#include "GLedBackend.h"
+
+// frame period of fading channels [ms]
+#ifndef GLED_PCA9685_FRAME_TIME
+#define GLED_PCA9685_FRAME_TIME 20
+#endif
+
+// pause before a failed transfer is repeated [ms], unless a fading channel sends the next frame earlier.
+#ifndef GLED_PCA9685_RETRY_MS
+#define GLED_PCA9685_RETRY_MS 100
+#endif
+
+/**
+ * The GLedPCA9685 drives LEDs on the 16 PWM outputs of a PCA9685.
+ * The PWM is generated by the device, on(), off() and set_brightness() only change the duty.
+ * breathe() fades are computed by a frame task of the backend.
+ * \n
+ * All channels changed in a frame are written with one auto increment burst,
+ * from the first to the last changed channel, so a fade of 16 LEDs costs one I2C transfer per frame.
+ * The channels start their on time staggered by 1/16 of the PWM period,
+ * which spreads the switching current over the period.
+ * \n
+ * The I2C driver of the port has to be installed before begin(), see GLedExpander.
+ * For host builds the bus write function of the simulated device in extras/host may be given.
+ */
+class GLedPCA9685 : public GLedBackend {
+public:
+    static const unsigned OUTPUTS = 16;          ///< outputs of a PCA9685.
+    static const unsigned MAX_DUTY = 4096;       ///< duty of a fully on output.
+    static const int DEFAULT_FREQUENCY = 1000;   ///< default PWM frequency [Hz]
+    static const int I2C_TIMEOUT = 10;           ///< timeout of an I2C transfer [ms]
+
+    /**
+     * @param port: I2C port, for ex. I2C_NUM_0.
+     * @param address: 7 bit I2C address, 0x40 by default.
+     * @param frequency: PWM frequency 24..1526 Hz.
+     */
+    GLedPCA9685( i2c_port_t port, uint8_t address = 0x40, int frequency = DEFAULT_FREQUENCY );
+
+    /**
+     * use a bus write function instead of the I2C driver.
+     * @param address: 7 bit I2C address.
+     * @param bus_write: function writing a transaction.
+     * @param ctx: first argument of bus_write.
+     * @param frequency: PWM frequency 24..1526 Hz.
+     */
+    GLedPCA9685( uint8_t address, gled_i2c_write_t bus_write, void *ctx, int frequency = DEFAULT_FREQUENCY );
+
+    ~GLedPCA9685();
+
+    /**
+     * configure the device (totem pole outputs, auto increment, frequency), switch all outputs off
+     * and start the frame task.
+     * @param core: core to run the frame task.
+     * @return ESP_OK, ESP_ERR_NO_MEM or the error code of the bus.
+     */
+    esp_err_t begin( int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the frame task, pending changes are sent before.
+     */
+    void end();
+
+    /**
+     * send the changes of the current frame now, in the context of the caller.
+     * Meant for use without the frame task, for ex. on the host.
+     * After an error the changes stay pending and the next flush() sends them again,
+     * the frame task repeats a failed transfer after GLED_PCA9685_RETRY_MS.
+     * @return ESP_OK or the error code of the bus.
+     */
+    esp_err_t flush();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+    esp_err_t set_brightness( unsigned channel, uint8_t duty ) override;
+    esp_err_t breathe( unsigned channel, unsigned period_ms, uint8_t from, uint8_t to ) override;
+
+    uint32_t get_transactions() const { return transactions; }   ///< number of bus transactions.
+    uint32_t get_errors() const { return errors; }               ///< number of failed bus transactions.
+
+private:
+    typedef struct {
+        std::atomic<uint16_t> duty;    ///< steady duty 0..MAX_DUTY.
+        std::atomic<bool> fading;
+        TickType_t fade_start;
+        TickType_t fade_period;
+        uint16_t fade_from;
+        uint16_t fade_to;
+        uint16_t sent;                 ///< duty written to the device.
+    } channel_t;
+
+    i2c_port_t port;
+    uint8_t address;
+    int frequency;
+    gled_i2c_write_t bus_write;
+    void * bus_ctx;
+    channel_t channels[OUTPUTS];
+    bool sent_valid;
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<bool> dirty;
+    std::atomic<uint32_t> transactions;
+    std::atomic<uint32_t> errors;
+
+    static uint16_t scale( uint8_t duty ) { return (duty * MAX_DUTY + 127) / 255; }
+    uint16_t frame_duty( const channel_t & c, TickType_t now ) const;
+    bool is_fading() const;
+    void wake();
+    esp_err_t write_bytes( const uint8_t *data, size_t len );
+    static esp_err_t i2c_write( void *ctx, uint8_t address, const uint8_t *data, size_t len );
+
+friend
+    void task_gled_pca9685( void *pvParameters );
+};
+
+#endif
+
+// eof
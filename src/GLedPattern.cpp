@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedPattern class holds a blinking pattern for GLed.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPattern.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedPattern.h"
+
+// morse code of 'A'..'Z' and '0'..'9'.
+// Read from the highest set bit, which is only a start marker, to bit 0: 0 is a dot, 1 a dash.
+static const uint8_t morse_letters[26] = {
+	0x05, 0x18, 0x1A, 0x0C, 0x02, 0x12, 0x0E, 0x10, 0x04, 0x17, 0x0D, 0x14, 0x07,  // A..M
+	0x06, 0x0F, 0x16, 0x1D, 0x0A, 0x08, 0x03, 0x09, 0x11, 0x0B, 0x19, 0x1B, 0x1C   // N..Z
+};
+static const uint8_t morse_digits[10] = {
+	0x3F, 0x2F, 0x27, 0x23, 0x21, 0x20, 0x30, 0x38, 0x3C, 0x3E                     // 0..9
+};
+
+static const unsigned MORSE_DOT = 1;
+static const unsigned MORSE_DASH = 3;
+static const unsigned MORSE_ELEMENT_GAP = 1;
+static const unsigned MORSE_LETTER_GAP = 3;
+static const unsigned MORSE_WORD_GAP = 7;
+
+void GLedPattern::set_flash( unsigned dt_on, unsigned dt_off )
+{
+	// use 1 ms units as long as the intervals fit into a step.
+	const unsigned dt_max = dt_on > dt_off ? dt_on : dt_off;
+
+	unit = 1 + dt_max / 0x10000;
+	length = 0;
+	append( dt_on / unit, dt_off / unit );
+}
+
+bool GLedPattern::append( unsigned on_units, unsigned off_units )
+{
+	if( length + 2u > MAX_STEPS )
+		return false;
+
+	step[length++] = on_units;
+	step[length++] = off_units;
+	return true;
+}
+
+unsigned GLedPattern::compile_morse( const char *text, unsigned unit_ms )
+{
+	unsigned chars = 0;
+
+	unit = unit_ms > 0 ? unit_ms : 1;
+	length = 0;
+
+	for( ; text != nullptr && *text != '\0'; text++ ) {
+		const char c = *text;
+		uint8_t code;
+
+		if( c == ' ' ) {
+			if( length > 0 )
+				step[length - 1] = MORSE_WORD_GAP;
+			chars++;
+			continue;
+		}
+		else if( c >= 'a' && c <= 'z' )
+			code = morse_letters[c - 'a'];
+		else if( c >= 'A' && c <= 'Z' )
+			code = morse_letters[c - 'A'];
+		else if( c >= '0' && c <= '9' )
+			code = morse_digits[c - '0'];
+		else
+			continue;
+
+		// check that the complete letter fits:
+		int bit = 7;
+		while( (code & (1 << bit)) == 0 )
+			bit--;
+		if( length + 2u * bit > MAX_STEPS )
+			break;
+
+		while( --bit >= 0 )
+			append( (code & (1 << bit)) ? MORSE_DASH : MORSE_DOT, bit > 0 ? MORSE_ELEMENT_GAP : MORSE_LETTER_GAP );
+		chars++;
+	}
+
+	if( length > 0 )   // pause before the message gets repeated.
+		step[length - 1] = MORSE_WORD_GAP;
+
+	return chars;
+}
+
+unsigned GLedPattern::compile_morse( unsigned code, unsigned unit_ms )
+{
+	char digits[12];
+
+	snprintf( digits, sizeof(digits), "%u", code );
+	return compile_morse( digits, unit_ms );
+}
+
+unsigned GLedPattern::period() const
+{
+	unsigned sum = 0;
+
+	for( unsigned i = 0; i < length; i++ )
+		sum += step[i];
+	return sum * unit;
+}
+
+// eof
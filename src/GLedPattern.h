@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedPattern class holds a blinking pattern for GLed.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPattern.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_PATTERN_HEADER_H
+#define GLED_PATTERN_HEADER_H
+
+#include <Arduino.h>
+
+// number of on/off intervals a pattern can hold.
+// Two intervals are needed per morse element, so 128 steps hold about 15 letters.
+#ifndef GLED_PATTERN_MAX_STEPS
+#define GLED_PATTERN_MAX_STEPS 128
+#endif
+
+/**
+ * A GLedPattern is a sequence of time intervals in which the LED is alternately
+ * on and off. The first interval is always an on interval.
+ * The intervals are stored in multiples of a time unit, so a pattern
+ * is compiled once and then played by the flash task without further computation.
+ * The storage is part of the object, no memory gets allocated.
+ */
+class GLedPattern {
+public:
+    static const unsigned MAX_STEPS = GLED_PATTERN_MAX_STEPS;   ///< capacity of a pattern [intervals].
+
+    GLedPattern()
+        : length(0)
+        , unit(1)
+    {};
+
+    /**
+     * remove all intervals.
+     */
+    void clear() { length = 0; }
+
+    /**
+     * make a simple flash pattern: one on and one off interval.
+     * @param dt_on: time during which the LED is ON (ms).
+     * @param dt_off: time during which the LED is OFF (ms).
+     */
+    void set_flash( unsigned dt_on, unsigned dt_off );
+
+    /**
+     * append one on and one off interval, for ex. to build an arbitrary waveform after set_flash().
+     * The times are rounded down to the time unit of the pattern.
+     * @param dt_on: time during which the LED is ON (ms).
+     * @param dt_off: time during which the LED is OFF (ms).
+     * @return false if the pattern is full.
+     */
+    bool add_flash( unsigned dt_on, unsigned dt_off ) { return append( dt_on / unit, dt_off / unit ); }
+
+    /**
+     * compile a text into morse code.
+     * Letters, digits and the blank are known, other characters are ignored.
+     * The elements are timed by the standard morse rules: a dot is one unit,
+     * a dash three units, the gap within a letter one, between letters three and
+     * between words seven units. A word gap is appended to the end of the text,
+     * so a repeated message stays readable.
+     * If the text does not fit into the pattern it is truncated after the last complete letter.
+     * @param text: the message.
+     * @param unit_ms: duration of a morse unit (ms).
+     * @return the number of characters compiled into the pattern.
+     */
+    unsigned compile_morse( const char *text, unsigned unit_ms );
+
+    /**
+     * compile a number into morse code, for example an error code.
+     * @param code: the number to be signaled as decimal digits.
+     * @param unit_ms: duration of a morse unit (ms).
+     * @return the number of digits compiled into the pattern.
+     */
+    unsigned compile_morse( unsigned code, unsigned unit_ms );
+
+    /**
+     * get the number of intervals.
+     */
+    unsigned size() const { return length; }
+
+    /**
+     * get the LED state of an interval.
+     * @param i: interval index.
+     * @returns true if the LED is on during the interval.
+     */
+    static bool level( unsigned i ) { return (i & 1) == 0; }
+
+    /**
+     * get the duration of an interval.
+     * @param i: interval index, must be less than size().
+     * @returns the duration (ms).
+     */
+    unsigned duration( unsigned i ) const { return step[i] * unit; }
+
+    /**
+     * get the duration of the whole pattern.
+     * @returns the sum of all intervals (ms).
+     */
+    unsigned period() const;
+
+private:
+    uint16_t step[MAX_STEPS];   ///< interval durations [unit]
+    uint16_t length;
+    unsigned unit;              ///< [ms]
+
+    bool append( unsigned on_units, unsigned off_units );
+};
+
+#endif
+
+// eof
@@ -0,0 +1,292 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       addressable RGB LEDs (WS2812) driven by the RMT.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPixels.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_caps.h>
+
+#include "GLedPixels.h"
+
+void task_gled_pixels( void *pvParameters );
+
+static const char* TAG = "GLED";
+
+// RMT symbols at 10 MHz: level0 and duration0 in the low half word, level1 and duration1 in the high half word.
+static const uint32_t RMT_RESOLUTION = 10000000;
+#define GLED_SYMBOL( level0, duration0, level1, duration1 ) \
+	((uint32_t) (duration0) | ((uint32_t) (level0) << 15) | ((uint32_t) (duration1) << 16) | ((uint32_t) (level1) << 31))
+static const uint32_t SYMBOL_0 = GLED_SYMBOL( 1, 3, 0, 9 );         // 0.3 us high, 0.9 us low
+static const uint32_t SYMBOL_1 = GLED_SYMBOL( 1, 9, 0, 3 );         // 0.9 us high, 0.3 us low
+static const uint32_t SYMBOL_RESET = GLED_SYMBOL( 0, 1500, 0, 1500 ); // 300 us low latches the colors.
+
+GLedPixels::GLedPixels( int a_pin, unsigned a_count, color_order_t a_order, int a_rmt_channel )
+	: pin(a_pin)
+	, count(a_count)
+	, order(a_order)
+	, rmt_channel(a_rmt_channel)
+	, pixels(nullptr)
+	, symbols()
+	, n_symbols(a_count * 24 + 1)
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	, channel(nullptr)
+	, encoder(nullptr)
+#endif
+	, installed(false)
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transfers(0)
+{
+}
+
+GLedPixels::~GLedPixels()
+{
+	end();
+	delete[] pixels;
+}
+
+esp_err_t GLedPixels::begin( int core_num )
+{
+	esp_err_t rc;
+
+	if( task_handle != nullptr )
+		return ESP_OK;
+
+	if( pixels == nullptr ) {   // the pixels keep their colors over end() and begin().
+		pixels = new pixel_t[count];
+		for( unsigned i = 0; i < count; i++ ) {
+			pixels[i].color = DEFAULT_COLOR;
+			pixels[i].level = 0;
+		}
+	}
+	for( int i = 0; i < 2; i++ ) {
+		symbols[i] = (uint32_t*) heap_caps_malloc( n_symbols * sizeof(uint32_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT );
+		if( symbols[i] == nullptr ) {
+			release();
+			return ESP_ERR_NO_MEM;
+		}
+	}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	rmt_tx_channel_config_t config = {};
+	config.gpio_num = pin;
+	config.clk_src = RMT_CLK_SRC_DEFAULT;
+	config.resolution_hz = RMT_RESOLUTION;
+	config.trans_queue_depth = 2;
+#if SOC_RMT_SUPPORT_DMA
+	config.mem_block_symbols = 1024;
+	config.flags.with_dma = 1;
+#else
+	config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+#endif
+	rmt_copy_encoder_config_t encoder_config = {};
+
+	if( (rc = rmt_new_tx_channel( &config, &channel )) != ESP_OK
+	 || (rc = rmt_new_copy_encoder( &encoder_config, &encoder )) != ESP_OK
+	 || (rc = rmt_enable( channel )) != ESP_OK ) {
+		release();
+		return rc;
+	}
+#else
+	rmt_config_t config = RMT_DEFAULT_CONFIG_TX( (gpio_num_t) pin, (rmt_channel_t) rmt_channel );
+	config.clk_div = APB_CLK_FREQ / RMT_RESOLUTION;
+
+	if( (rc = rmt_config( &config )) != ESP_OK
+	 || (rc = rmt_driver_install( (rmt_channel_t) rmt_channel, 0, 0 )) != ESP_OK ) {
+		release();
+		return rc;
+	}
+#endif
+	installed = true;
+
+	ESP_LOGI( TAG, "pixels on gpio%d: %u pixels, frame of %u symbols", pin, count, (unsigned) n_symbols );
+
+	quit = false;
+	dirty = true;   // the first frame sets all pixels.
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_pixels, "task_gled_pixels", 2048, this, 1, & handle, core_num ) != pdPASS ) {
+		release();
+		return ESP_ERR_NO_MEM;
+	}
+	task_handle = handle;
+	xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+void GLedPixels::end()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( handle != nullptr ) {
+		quit = true;
+		xTaskNotifyGive( handle );
+		while( task_handle != nullptr )
+			vTaskDelay( 1 );
+	}
+	release();
+}
+
+void GLedPixels::release()
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	if( installed )
+		rmt_disable( channel );
+	if( channel != nullptr ) {
+		rmt_del_channel( channel );
+		channel = nullptr;
+	}
+	if( encoder != nullptr ) {
+		rmt_del_encoder( encoder );
+		encoder = nullptr;
+	}
+#else
+	if( installed )
+		rmt_driver_uninstall( (rmt_channel_t) rmt_channel );
+#endif
+	installed = false;
+	for( int i = 0; i < 2; i++ ) {
+		if( symbols[i] != nullptr ) {
+			heap_caps_free( symbols[i] );
+			symbols[i] = nullptr;
+		}
+	}
+}
+
+esp_err_t GLedPixels::attach( unsigned channel_num )
+{
+	return channel_num < count && pixels != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void GLedPixels::wake()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( ! dirty.exchange( true ) && handle != nullptr )
+		xTaskNotifyGive( handle );
+}
+
+void GLedPixels::write( unsigned channel_num, bool level )
+{
+	if( channel_num >= count || pixels == nullptr )
+		return;
+
+	const uint8_t new_level = level ? 255 : 0;
+	if( pixels[channel_num].level.exchange( new_level ) != new_level )
+		wake();
+}
+
+void IRAM_ATTR GLedPixels::write_from_isr( unsigned channel_num, bool level )
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( channel_num >= count || pixels == nullptr )
+		return;
+
+	const uint8_t new_level = level ? 255 : 0;
+	if( pixels[channel_num].level.exchange( new_level ) != new_level && ! dirty.exchange( true ) && handle != nullptr )
+		vTaskNotifyGiveFromISR( handle, nullptr );
+}
+
+esp_err_t GLedPixels::set_brightness( unsigned channel_num, uint8_t duty )
+{
+	if( channel_num >= count || pixels == nullptr )
+		return ESP_ERR_INVALID_ARG;
+
+	if( pixels[channel_num].level.exchange( duty ) != duty )
+		wake();
+	return ESP_OK;
+}
+
+esp_err_t GLedPixels::set_color( unsigned channel_num, uint32_t rgb )
+{
+	if( channel_num >= count || pixels == nullptr )
+		return ESP_ERR_INVALID_ARG;
+
+	if( pixels[channel_num].color.exchange( rgb ) != rgb && pixels[channel_num].level != 0 )
+		wake();
+	return ESP_OK;
+}
+
+void GLedPixels::encode( uint32_t * buffer )
+{
+	uint32_t * s = buffer;
+
+	for( unsigned i = 0; i < count; i++ ) {
+		const uint32_t rgb = pixels[i].color.load( std::memory_order_relaxed );
+		const uint32_t level = pixels[i].level.load( std::memory_order_relaxed );
+		const uint32_t r = ((rgb >> 16) & 0xff) * level / 255;
+		const uint32_t g = ((rgb >> 8) & 0xff) * level / 255;
+		const uint32_t b = (rgb & 0xff) * level / 255;
+		const uint32_t bits = order == GRB ? (g << 16 | r << 8 | b) : (r << 16 | g << 8 | b);
+
+		for( int bit = 23; bit >= 0; bit-- )   // MSB first
+			*s++ = (bits >> bit) & 1 ? SYMBOL_1 : SYMBOL_0;
+	}
+	*s = SYMBOL_RESET;
+}
+
+esp_err_t GLedPixels::transmit( const uint32_t * buffer )
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	rmt_transmit_config_t config = {};
+	return rmt_transmit( channel, encoder, buffer, n_symbols * sizeof(uint32_t), &config );
+#else
+	return rmt_write_items( (rmt_channel_t) rmt_channel, (const rmt_item32_t*) buffer, n_symbols, false );
+#endif
+}
+
+void GLedPixels::wait_done()
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	rmt_tx_wait_all_done( channel, -1 );
+#else
+	rmt_wait_tx_done( (rmt_channel_t) rmt_channel, portMAX_DELAY );
+#endif
+}
+
+void task_gled_pixels( void *pvParameters )
+{
+	GLedPixels * pPixels = (GLedPixels*) pvParameters;
+	bool in_flight = false;
+	int next = 0;
+
+	while( ! pPixels->quit ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		// changes made while a frame is encoded or sent get into the next frame:
+		while( ! pPixels->quit && pPixels->dirty.exchange( false ) ) {
+			pPixels->encode( pPixels->symbols[next] );
+			if( in_flight )
+				pPixels->wait_done();
+			in_flight = pPixels->transmit( pPixels->symbols[next] ) == ESP_OK;
+			pPixels->transfers++;
+			next ^= 1;
+		}
+	}
+	if( in_flight )
+		pPixels->wait_done();
+
+	pPixels->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+// eof
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       addressable RGB LEDs (WS2812) driven by the RMT.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedPixels.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_PIXELS_HEADER_H
+#define GLED_PIXELS_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <driver/rmt_tx.h>
+#else
+#include <driver/rmt.h>
+#endif
+
+#include "GLed.h"
+#include "GLedBackend.h"
+
+/**
+ * The GLedPixels drives a strip of addressable RGB LEDs (WS2812, SK6812), each pixel is a GLed.
+ * A pixel shows its color (set_color()) while it is on, scaled by set_brightness().
+ * \n
+ * The colors are kept in a frame buffer. The first change after a transfer wakes a transfer task,
+ * which encodes the whole frame into RMT symbols and sends it. Two symbol buffers are used,
+ * the next frame is encoded while the RMT still sends the current one.
+ * Unchanged frames are not sent. On chips with RMT DMA (ESP32-S3) the DMA feeds the RMT.
+ * \n
+ * A pixel needs 24 symbols of 4 bytes in each of the two buffers, 192 bytes per pixel.
+ * \n
+ * Example, the RGB LED of an ESP32-S3 devkit:
+ * \code
+ * GLedPixels pixels( 48, 1 );
+ * GLed led( pixels, 0 );
+ *
+ * pixels.begin();
+ * led.begin();
+ * led.set_color( 0x00ff00 );
+ * led.async_flash();
+ * \endcode
+ */
+class GLedPixels : public GLedBackend {
+public:
+    enum color_order_t { GRB, RGB };            ///< order of the colors on the wire.
+
+    static const uint32_t DEFAULT_COLOR = 0xffffff;   ///< color of a pixel which is switched on.
+
+    /**
+     * @param pin: gpio connected to DIN of the first pixel.
+     * @param count: number of pixels.
+     * @param order: color order, GRB for WS2812.
+     * @param rmt_channel: RMT channel, only used with ESP-IDF 4, ESP-IDF 5 allocates a free channel.
+     */
+    GLedPixels( int pin, unsigned count, color_order_t order = GRB, int rmt_channel = 0 );
+
+    ~GLedPixels();
+
+    /**
+     * allocate the buffers, install the RMT channel and start the transfer task. All pixels are dark.
+     * @param core: core to run the transfer task.
+     * @return ESP_OK, ESP_ERR_NO_MEM or the error code of the RMT driver.
+     */
+    esp_err_t begin( int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the transfer task and release the RMT channel. The pixels keep their colors.
+     */
+    void end();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+    esp_err_t set_brightness( unsigned channel, uint8_t duty ) override;
+    esp_err_t set_color( unsigned channel, uint32_t rgb ) override;
+
+    /**
+     * get the number of frames sent.
+     */
+    uint32_t get_transfers() const { return transfers; }
+
+private:
+    typedef struct {
+        std::atomic<uint32_t> color;   ///< 0xRRGGBB while on.
+        std::atomic<uint8_t> level;    ///< brightness, 0 is off.
+    } pixel_t;
+
+    int pin;
+    unsigned count;
+    color_order_t order;
+    int rmt_channel;
+    pixel_t * pixels;
+    uint32_t * symbols[2];             ///< RMT symbols of a frame and the reset.
+    size_t n_symbols;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t encoder;
+#endif
+    bool installed;
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<bool> dirty;
+    std::atomic<uint32_t> transfers;
+
+    void wake();
+    void encode( uint32_t * buffer );
+    esp_err_t transmit( const uint32_t * buffer );
+    void wait_done();
+    void release();
+
+friend
+    void task_gled_pixels( void *pvParameters );
+};
+
+#endif
+
+// eof
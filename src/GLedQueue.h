@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       lock-free multi producer, single consumer queue.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedQueue.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_QUEUE_HEADER_H
+#define GLED_QUEUE_HEADER_H
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * A bounded queue for many producers and one consumer without any lock.
+ * Each cell carries a sequence number telling whether it is free for the producer
+ * or filled for the consumer (D. Vyukov's bounded queue).
+ * A producer reserves a cell by a compare and swap of the write position,
+ * so push() never blocks and may be called from any task or an ISR.
+ * pop() must only be called by a single consumer.
+ * @tparam T: element type, copied into the queue.
+ * @tparam N: capacity, must be a power of two.
+ */
+template <typename T, unsigned N>
+class GLedQueue {
+public:
+    static_assert( N >= 2 && (N & (N - 1)) == 0, "GLedQueue: N must be a power of two" );
+
+    GLedQueue()
+        : write_pos(0)
+        , read_pos(0)
+    {
+        for( unsigned i = 0; i < N; i++ )
+            cells[i].sequence.store( i, std::memory_order_relaxed );
+    }
+
+    /**
+     * append an element.
+     * @returns false if the queue is full.
+     */
+    bool push( const T & value )
+    {
+        uint32_t pos = write_pos.load( std::memory_order_relaxed );
+
+        for(;;) {
+            cell_t & cell = cells[pos & (N - 1)];
+            const int32_t diff = (int32_t)(cell.sequence.load( std::memory_order_acquire ) - pos);
+
+            if( diff == 0 ) {
+                if( write_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+                    cell.value = value;
+                    cell.sequence.store( pos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if( diff < 0 )
+                return false;   // the consumer has not yet read this cell.
+            else
+                pos = write_pos.load( std::memory_order_relaxed );
+        }
+    }
+
+    /**
+     * remove the oldest element. Single consumer only.
+     * @returns false if the queue is empty.
+     */
+    bool pop( T & value )
+    {
+        cell_t & cell = cells[read_pos & (N - 1)];
+
+        if( (int32_t)(cell.sequence.load( std::memory_order_acquire ) - (read_pos + 1)) < 0 )
+            return false;
+
+        value = cell.value;
+        cell.sequence.store( read_pos + N, std::memory_order_release );
+        read_pos++;
+        return true;
+    }
+
+private:
+    typedef struct {
+        std::atomic<uint32_t> sequence;
+        T value;
+    } cell_t;
+
+    cell_t cells[N];
+    std::atomic<uint32_t> write_pos;
+    uint32_t read_pos;
+};
+
+#endif
+
+// eof
@@ -0,0 +1,208 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedService class serializes LED commands of many tasks.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedService.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedGpio.h"
+#include "GLedService.h"
+
+void task_gled_commands( void *pvParameters );
+
+static const char* TAG = "GLED";
+
+GLedService::~GLedService()
+{
+	end();
+}
+
+esp_err_t GLedService::begin( int core_num )
+{
+	if( task_handle != nullptr )
+		return ESP_OK;
+
+	quit = false;
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_commands, "task_gled_commands", 2048, this, 2, & handle, core_num ) != pdPASS )
+		return ESP_ERR_NO_MEM;
+	task_handle = handle;
+	// commands posted before found no task to wake up:
+	if( ! wake_pending.exchange( true ) )
+		xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+void GLedService::end()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( handle == nullptr )
+		return;
+
+	quit = true;
+	xTaskNotifyGive( handle );
+	while( task_handle != nullptr )
+		vTaskDelay( 1 );
+}
+
+bool GLedService::on( GLed & led )                       { return post( led, CMD_ON ); }
+bool GLedService::off( GLed & led )                      { return post( led, CMD_OFF ); }
+bool GLedService::toggle( GLed & led )                   { return post( led, CMD_TOGGLE ); }
+bool GLedService::switch_lightening( GLed & led, bool mode ) { return post( led, mode ? CMD_ON : CMD_OFF ); }
+bool GLedService::brightness( GLed & led, uint8_t level ) { return post( led, CMD_BRIGHTNESS, level ); }
+
+bool GLedService::flash( GLed & led, uint64_t count, unsigned dt_on, unsigned dt_off )
+{
+	return post( led, CMD_FLASH, dt_on, dt_off, count );
+}
+
+bool GLedService::overlay( GLed & led, unsigned priority, const GLedPattern & pattern, uint64_t count )
+{
+	return post( led, CMD_OVERLAY, priority, 0, count, &pattern );
+}
+
+bool GLedService::post( GLed & led, uint8_t id, uint32_t arg1, uint32_t arg2, uint64_t count, const GLedPattern * pattern )
+{
+	const command_t cmd = { &led, pattern, count, arg1, arg2, id };
+
+	if( ! queue.push( cmd ) ) {
+		dropped.fetch_add( 1, std::memory_order_relaxed );
+		return false;
+	}
+
+	// only the first command of a batch wakes up the service task:
+	const TaskHandle_t handle = task_handle;
+	if( handle != nullptr && ! wake_pending.exchange( true ) )
+		xTaskNotifyGive( handle );
+	return true;
+}
+
+void task_gled_commands( void *pvParameters )
+{
+	GLedService * pService = (GLedService*) pvParameters;
+
+	ESP_LOGI( TAG, "task_gled_commands started" );
+	while( ! pService->quit ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		pService->drain();
+	}
+	pService->drain();
+
+	ESP_LOGW( TAG, "task_gled_commands terminating, %u commands dropped", pService->get_dropped() );
+	pService->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+void GLedService::drain()
+{
+	command_t cmd;
+
+	// commands posted from now on wake up the task again:
+	wake_pending = false;
+	while( queue.pop( cmd ) )
+		apply( cmd );
+	flush_pending();
+}
+
+void GLedService::apply( const command_t & cmd )
+{
+	GLed * led = cmd.led;
+
+	switch( cmd.id ) {
+	case CMD_ON:
+		add_pending( led, true );
+		return;
+	case CMD_OFF:
+		add_pending( led, false );
+		return;
+	case CMD_TOGGLE:
+		for( unsigned i = 0; i < n_pending; i++ ) {
+			if( pending[i].led == led ) {
+				pending[i].lightening = ! pending[i].lightening;
+				return;
+			}
+		}
+		add_pending( led, ! led->is_on() );
+		return;
+	default:
+		break;
+	}
+
+	// the other commands start asynchronous actions, keep the order to the switching commands:
+	flush_pending();
+	switch( cmd.id ) {
+	case CMD_FLASH:
+		led->async_flash( cmd.count, cmd.arg1, cmd.arg2 );
+		break;
+	case CMD_OVERLAY:
+		led->async_overlay( cmd.arg1, *cmd.pattern, cmd.count );
+		break;
+	case CMD_BRIGHTNESS:
+		led->set_brightness( cmd.arg1 );
+		break;
+	}
+}
+
+void GLedService::add_pending( GLed * led, bool lightening )
+{
+	for( unsigned i = 0; i < n_pending; i++ ) {
+		if( pending[i].led == led ) {   // coalesce: only the last state counts.
+			pending[i].lightening = lightening;
+			return;
+		}
+	}
+	if( n_pending >= GLED_SERVICE_BATCH )
+		flush_pending();
+
+	pending[n_pending].led = led;
+	pending[n_pending].lightening = lightening;
+	n_pending++;
+}
+
+void GLedService::flush_pending()
+{
+	GLedGpioMask mask;
+
+	for( unsigned i = 0; i < n_pending; i++ ) {
+		GLed * led = pending[i].led;
+
+		if( ! led->activated )
+			continue;
+		if( led->dimmer_attached || led->backend != nullptr )   // breathing or dimmed, or not a native gpio.
+			led->switch_lightening( pending[i].lightening );
+		else {
+			led->state = pending[i].lightening ? 1 : 0;
+			mask.add( led->pin, led->gpio_level( pending[i].lightening ) );
+		}
+	}
+	mask.elide();
+	mask.write();
+
+	// a direct GLed call of another task may have changed a state meanwhile, see GLed::write_state():
+	for( unsigned i = 0; i < n_pending; i++ ) {
+		GLed * led = pending[i].led;
+		if( led->activated && ! led->dimmer_attached && led->backend == nullptr && led->is_on() != pending[i].lightening )
+			led->write_state( led->state, true );
+	}
+	n_pending = 0;
+}
+
+// eof
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedService class serializes LED commands of many tasks.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedService.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SERVICE_HEADER_H
+#define GLED_SERVICE_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "GLed.h"
+#include "GLedQueue.h"
+
+// number of commands the queue can hold, must be a power of two.
+#ifndef GLED_SERVICE_QUEUE_SIZE
+#define GLED_SERVICE_QUEUE_SIZE 64
+#endif
+
+// number of LEDs whose on/off commands are collected into one gpio write.
+#ifndef GLED_SERVICE_BATCH
+#define GLED_SERVICE_BATCH 32
+#endif
+
+/**
+ * The GLedService accepts LED commands from any task and applies them in a single service task.
+ * The commands are posted into a lock-free queue, so a posting task never waits for a lock.
+ * The service task is woken up once per batch of commands and drains the whole queue.
+ * On and off commands are coalesced per LED, only the final state of each LED is written,
+ * and the LEDs on native gpio pins are written together with one register access per bank.
+ * \n
+ * All methods return immediately, false if the command was dropped because the queue was full.
+ * The commands of one task are applied in the order they were posted.
+ */
+class GLedService {
+public:
+    GLedService()
+        : task_handle(nullptr)
+        , quit(false)
+        , wake_pending(false)
+        , dropped(0)
+        , n_pending(0)
+    {};
+
+    ~GLedService();
+
+    /**
+     * start the service task. Commands posted before get applied at once.
+     * @param core: core to run the service task.
+     * @return ESP_OK, or ESP_ERR_NO_MEM if the task could not be created.
+     */
+    esp_err_t begin( int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the service task. Commands still in the queue get applied before.
+     */
+    void end();
+
+    bool on( GLed & led );                                   ///< post GLed::on().
+    bool off( GLed & led );                                  ///< post GLed::off().
+    bool toggle( GLed & led );                               ///< post GLed::toggle().
+    bool switch_lightening( GLed & led, bool mode );         ///< post GLed::switch_lightening().
+
+    /**
+     * post GLed::async_flash().
+     */
+    bool flash( GLed & led,
+                uint64_t count = GLed::FLASH_FOR_EVER,
+                unsigned dt_on = GLed::DEFAULT_FLASH_ON_TIME,
+                unsigned dt_off = GLed::DEFAULT_FLASH_OFF_TIME );
+
+    /**
+     * post GLed::async_overlay(). The pattern must stay valid while the overlay runs.
+     */
+    bool overlay( GLed & led, unsigned priority, const GLedPattern & pattern, uint64_t count = 1 );
+
+    /**
+     * post GLed::set_brightness().
+     */
+    bool brightness( GLed & led, uint8_t level );
+
+    /**
+     * get the number of commands dropped because the queue was full.
+     */
+    uint32_t get_dropped() const { return dropped; }
+
+private:
+    enum command_id_t { CMD_ON, CMD_OFF, CMD_TOGGLE, CMD_FLASH, CMD_OVERLAY, CMD_BRIGHTNESS };
+
+    typedef struct {
+        GLed * led;
+        const GLedPattern * pattern;
+        uint64_t count;
+        uint32_t arg1;
+        uint32_t arg2;
+        uint8_t id;
+    } command_t;
+
+    typedef struct {
+        GLed * led;
+        bool lightening;
+    } pending_t;
+
+    GLedQueue<command_t, GLED_SERVICE_QUEUE_SIZE> queue;
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<bool> wake_pending;    ///< the service task has been notified and not yet started to drain.
+    std::atomic<uint32_t> dropped;
+    pending_t pending[GLED_SERVICE_BATCH];   ///< coalesced on/off states of the current batch.
+    unsigned n_pending;
+
+    bool post( GLed & led, uint8_t id, uint32_t arg1 = 0, uint32_t arg2 = 0,
+               uint64_t count = 0, const GLedPattern * pattern = nullptr );
+    void drain();
+    void apply( const command_t & cmd );
+    void add_pending( GLed * led, bool lightening );
+    void flush_pending();
+
+friend
+    void task_gled_commands( void *pvParameters );
+};
+
+#endif
+
+// eof
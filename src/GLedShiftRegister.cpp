@@ -0,0 +1,206 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on a chain of 74HC595 shift registers driven by SPI DMA.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedShiftRegister.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#include "GLedShiftRegister.h"
+
+void task_gled_shift( void *pvParameters );
+
+static const char* TAG = "GLED";
+
+GLedShiftRegister::GLedShiftRegister( spi_host_device_t a_host, int a_mosi, int a_sclk, int a_latch, unsigned a_outputs, int a_clock_hz )
+	: host(a_host)
+	, mosi(a_mosi)
+	, sclk(a_sclk)
+	, latch(a_latch)
+	, outputs(a_outputs < GLED_SHIFT_MAX_OUTPUTS ? a_outputs : GLED_SHIFT_MAX_OUTPUTS)
+	, n_bytes((outputs + 7) / 8)
+	, clock_hz(a_clock_hz)
+	, bus_owner(false)
+	, device(nullptr)
+	, frame()
+	, dma_buffer()
+	, transaction()
+	, task_handle(nullptr)
+	, quit(false)
+	, dirty(false)
+	, transfers(0)
+{
+}
+
+GLedShiftRegister::~GLedShiftRegister()
+{
+	end();
+}
+
+esp_err_t GLedShiftRegister::begin( int core_num )
+{
+	esp_err_t rc;
+
+	if( task_handle != nullptr )
+		return ESP_OK;
+
+	spi_bus_config_t bus = {};
+	bus.mosi_io_num = mosi;
+	bus.miso_io_num = -1;
+	bus.sclk_io_num = sclk;
+	bus.quadwp_io_num = -1;
+	bus.quadhd_io_num = -1;
+	bus.max_transfer_sz = n_bytes;
+
+	rc = spi_bus_initialize( host, &bus, SPI_DMA_CH_AUTO );
+	if( rc == ESP_OK )
+		bus_owner = true;
+	else if( rc != ESP_ERR_INVALID_STATE )   // ESP_ERR_INVALID_STATE: the bus is in use by other devices.
+		return rc;
+
+	spi_device_interface_config_t dev = {};
+	dev.clock_speed_hz = clock_hz;
+	dev.mode = 0;
+	dev.spics_io_num = latch;
+	dev.queue_size = 2;
+
+	if( (rc = spi_bus_add_device( host, &dev, &device )) != ESP_OK ) {
+		end();
+		return rc;
+	}
+
+	for( int i = 0; i < 2; i++ ) {
+		dma_buffer[i] = (uint8_t*) heap_caps_malloc( (n_bytes + 3) & ~3u, MALLOC_CAP_DMA );
+		if( dma_buffer[i] == nullptr ) {
+			end();
+			return ESP_ERR_NO_MEM;
+		}
+		memset( &transaction[i], 0, sizeof(spi_transaction_t) );
+		transaction[i].length = n_bytes * 8;
+		transaction[i].tx_buffer = dma_buffer[i];
+	}
+
+	ESP_LOGI( TAG, "shift register chain: %u outputs, frame of %u bytes", outputs, n_bytes );
+
+	quit = false;
+	dirty = true;   // the first frame sets all outputs.
+	TaskHandle_t handle;
+	if( xTaskCreatePinnedToCore( task_gled_shift, "task_gled_shift", 2048, this, 1, & handle, core_num ) != pdPASS ) {
+		end();
+		return ESP_ERR_NO_MEM;
+	}
+	task_handle = handle;
+	xTaskNotifyGive( handle );
+	return ESP_OK;
+}
+
+void GLedShiftRegister::end()
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( handle != nullptr ) {
+		quit = true;
+		xTaskNotifyGive( handle );
+		while( task_handle != nullptr )
+			vTaskDelay( 1 );
+	}
+	if( device != nullptr ) {
+		spi_bus_remove_device( device );
+		device = nullptr;
+	}
+	if( bus_owner ) {
+		spi_bus_free( host );
+		bus_owner = false;
+	}
+	for( int i = 0; i < 2; i++ ) {
+		if( dma_buffer[i] != nullptr ) {
+			heap_caps_free( dma_buffer[i] );
+			dma_buffer[i] = nullptr;
+		}
+	}
+}
+
+esp_err_t GLedShiftRegister::attach( unsigned channel )
+{
+	return channel < outputs ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+bool IRAM_ATTR GLedShiftRegister::set_level( unsigned channel, bool level )
+{
+	const uint32_t bit = 1u << (channel & 31);
+	std::atomic<uint32_t> & word = frame[channel >> 5];
+	const uint32_t old = level ? word.fetch_or( bit ) : word.fetch_and( ~bit );
+
+	// only the first change after a transfer wakes up the transfer task:
+	return ((old & bit) != 0) != level && ! dirty.exchange( true );
+}
+
+void GLedShiftRegister::write( unsigned channel, bool level )
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( channel < outputs && set_level( channel, level ) && handle != nullptr )
+		xTaskNotifyGive( handle );
+}
+
+void IRAM_ATTR GLedShiftRegister::write_from_isr( unsigned channel, bool level )
+{
+	const TaskHandle_t handle = task_handle;
+
+	if( channel < outputs && set_level( channel, level ) && handle != nullptr )
+		vTaskNotifyGiveFromISR( handle, nullptr );
+}
+
+void GLedShiftRegister::build_frame( uint8_t * buffer )
+{
+	// the first byte sent ends up in the last register of the chain, MSB first is Q7.
+	for( unsigned i = 0; i < n_bytes; i++ )
+		buffer[n_bytes - 1 - i] = (uint8_t) (frame[i >> 2].load( std::memory_order_relaxed ) >> ((i & 3) * 8));
+}
+
+void task_gled_shift( void *pvParameters )
+{
+	GLedShiftRegister * pChain = (GLedShiftRegister*) pvParameters;
+	spi_transaction_t * done;
+	bool in_flight = false;
+	int next = 0;
+
+	while( ! pChain->quit ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		// changes made while a frame is built or sent get into the next frame:
+		while( ! pChain->quit && pChain->dirty.exchange( false ) ) {
+			pChain->build_frame( pChain->dma_buffer[next] );
+			if( in_flight )
+				spi_device_get_trans_result( pChain->device, &done, portMAX_DELAY );
+			in_flight = spi_device_queue_trans( pChain->device, &pChain->transaction[next], portMAX_DELAY ) == ESP_OK;
+			pChain->transfers++;
+			next ^= 1;
+		}
+	}
+	if( in_flight )
+		spi_device_get_trans_result( pChain->device, &done, portMAX_DELAY );
+
+	pChain->task_handle = nullptr;
+	vTaskDelete(NULL);
+}
+
+// eof
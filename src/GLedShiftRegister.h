@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       LEDs on a chain of 74HC595 shift registers driven by SPI DMA.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedShiftRegister.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_SHIFT_REGISTER_HEADER_H
+#define GLED_SHIFT_REGISTER_HEADER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/spi_master.h>
+
+#include "GLed.h"
+#include "GLedBackend.h"
+
+// highest number of outputs of one chain.
+#ifndef GLED_SHIFT_MAX_OUTPUTS
+#define GLED_SHIFT_MAX_OUTPUTS 256
+#endif
+
+/**
+ * The GLedShiftRegister drives LEDs on a chain of 74HC595 shift registers.
+ * The levels of all outputs are kept in a frame buffer, one bit per output.
+ * A GLed of the chain only changes its bit, a transfer task sends the whole frame
+ * by SPI DMA when a bit has changed. The frame is copied into one of two DMA buffers,
+ * so the next frame is built while the DMA still sends the current one.
+ * \n
+ * Wiring: MOSI to SER (DS) of the first register, SCLK to SRCLK (SHCP) of all registers,
+ * the chip select pin to RCLK (STCP) of all registers. The rising edge of the chip select
+ * at the end of a transfer latches the new frame to all outputs at once.
+ * Output 0 is Q0 of the first register, output 8 is Q0 of the second register and so on.
+ * \n
+ * Example:
+ * \code
+ * GLedShiftRegister chain( SPI2_HOST, 23, 18, 5, 64 );
+ * GLed led( chain, 12 );
+ *
+ * chain.begin();
+ * led.begin();
+ * led.async_flash();
+ * \endcode
+ */
+class GLedShiftRegister : public GLedBackend {
+public:
+    static const int DEFAULT_CLOCK = 10000000;    ///< default SPI clock [Hz]
+
+    /**
+     * @param host: SPI peripheral, for ex. SPI2_HOST.
+     * @param mosi: gpio connected to SER of the first register.
+     * @param sclk: gpio connected to SRCLK.
+     * @param latch: gpio connected to RCLK.
+     * @param outputs: number of outputs of the chain, 8 per register, at most GLED_SHIFT_MAX_OUTPUTS.
+     * @param clock_hz: SPI clock.
+     */
+    GLedShiftRegister( spi_host_device_t host, int mosi, int sclk, int latch, unsigned outputs, int clock_hz = DEFAULT_CLOCK );
+
+    ~GLedShiftRegister();
+
+    /**
+     * initialize the SPI bus and start the transfer task. All outputs are set LOW.
+     * The bus may be shared with other devices if it is initialized already.
+     * @param core: core to run the transfer task.
+     * @return ESP_OK or the error code of the SPI driver.
+     */
+    esp_err_t begin( int core = FLASH_TASK_CORE );
+
+    /**
+     * stop the transfer task and release the SPI device. The outputs keep their levels.
+     */
+    void end();
+
+    esp_err_t attach( unsigned channel ) override;
+    void write( unsigned channel, bool level ) override;
+    void IRAM_ATTR write_from_isr( unsigned channel, bool level ) override;
+
+    /**
+     * get the number of frames sent.
+     */
+    uint32_t get_transfers() const { return transfers; }
+
+private:
+    static const unsigned WORDS = (GLED_SHIFT_MAX_OUTPUTS + 31) / 32;
+
+    spi_host_device_t host;
+    int mosi;
+    int sclk;
+    int latch;
+    unsigned outputs;
+    unsigned n_bytes;                   ///< length of a frame
+    int clock_hz;
+    bool bus_owner;                     ///< the bus was initialized by begin().
+    spi_device_handle_t device;
+    std::atomic<uint32_t> frame[WORDS]; ///< level of output n is bit n.
+    uint8_t * dma_buffer[2];
+    spi_transaction_t transaction[2];
+    volatile TaskHandle_t task_handle;
+    volatile bool quit;
+    std::atomic<bool> dirty;            ///< the frame has changed since the last transfer was started.
+    std::atomic<uint32_t> transfers;
+
+    bool set_level( unsigned channel, bool level );
+    void build_frame( uint8_t * buffer );
+
+friend
+    void task_gled_shift( void *pvParameters );
+};
+
+#endif
+
+// eof
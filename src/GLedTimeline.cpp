@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedTimeline class plays synchronized sequences on several LEDs.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedTimeline.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedGpio.h"
+#include "GLedTimeline.h"
+
+static const char* TAG = "GLED";
+
+GLedTimeline::~GLedTimeline()
+{
+	stop();
+	if( timer != nullptr )
+		esp_timer_delete( timer );
+}
+
+int GLedTimeline::add_track( GLed & led )
+{
+	if( n_tracks >= MAX_TRACKS )
+		return -1;
+
+	tracks[n_tracks] = &led;
+	return n_tracks++;
+}
+
+bool GLedTimeline::add_key( int track, unsigned time_ms, bool lightening )
+{
+	if( track < 0 || (unsigned) track >= n_tracks || time_ms >= period || n_keys >= MAX_KEYS )
+		return false;
+
+	// keep the list sorted by time, keyframes of the same instant stay in the order of their creation.
+	unsigned i = n_keys++;
+	for( ; i > 0 && keys[i - 1].time > time_ms; i-- )
+		keys[i] = keys[i - 1];
+
+	keys[i].time = time_ms;
+	keys[i].track = track;
+	keys[i].lightening = lightening;
+	return true;
+}
+
+bool GLedTimeline::add_pulse( int track, unsigned time_ms, unsigned dt_on )
+{
+	if( n_keys + 2 > MAX_KEYS || period == 0 )
+		return false;
+
+	return add_key( track, time_ms, true )
+		&& add_key( track, (time_ms + dt_on) % period, false );
+}
+
+void GLedTimeline::clear()
+{
+	stop();
+	n_tracks = 0;
+	n_keys = 0;
+}
+
+esp_err_t GLedTimeline::start( uint64_t a_count )
+{
+	esp_err_t rc;
+
+	if( n_keys == 0 || a_count == 0 )
+		return ESP_ERR_INVALID_STATE;
+
+	if( timer == nullptr ) {
+		esp_timer_create_args_t timer_args = {};
+		timer_args.callback = on_timer;
+		timer_args.arg = this;
+		timer_args.dispatch_method = ESP_TIMER_TASK;
+		timer_args.name = "gled_timeline";
+		if( (rc = esp_timer_create( &timer_args, &timer )) != ESP_OK )
+			return rc;
+	}
+
+	stop();
+	ESP_LOGI( TAG, "timeline start: %u tracks, %u keys, period=%u ms", n_tracks, n_keys, period );
+
+	count = a_count;
+	cursor = 0;
+	cycle_start = esp_timer_get_time();
+	running = true;
+	schedule_next();
+	return ESP_OK;
+}
+
+void GLedTimeline::stop()
+{
+	running = false;   // a timer callback in progress does not reschedule.
+	if( timer != nullptr )
+		esp_timer_stop( timer );
+}
+
+void GLedTimeline::on_timer( void *arg )
+{
+	GLedTimeline * pTimeline = (GLedTimeline*) arg;
+
+	if( pTimeline->running ) {
+		pTimeline->apply_instant();
+		pTimeline->schedule_next();
+	}
+}
+
+void GLedTimeline::apply_instant()
+{
+	GLedGpioMask mask;
+	const uint32_t now = keys[cursor].time;
+
+	// collect all keyframes of this instant:
+	for( ; cursor < n_keys && keys[cursor].time == now; cursor++ ) {
+		GLed * pGLed = tracks[keys[cursor].track];
+		if( pGLed->activated ) {
+			pGLed->state = keys[cursor].lightening ? 1 : 0;
+			if( pGLed->backend != nullptr )   // the backend collects the changes for its transfer task.
+				pGLed->backend->write( pGLed->pin, pGLed->gpio_level( keys[cursor].lightening ) );
+			else
+				mask.add( pGLed->pin, pGLed->gpio_level( keys[cursor].lightening ) );
+		}
+	}
+	mask.elide();
+	mask.write();
+
+	if( cursor >= n_keys ) {   // end of the period
+		cursor = 0;
+		cycle_start += (int64_t) period * 1000;
+		if( count != PLAY_FOR_EVER && --count == 0 )
+			running = false;
+	}
+}
+
+void GLedTimeline::schedule_next()
+{
+	if( ! running )
+		return;
+
+	const int64_t dt = cycle_start + (int64_t) keys[cursor].time * 1000 - esp_timer_get_time();
+	esp_timer_start_once( timer, dt > 0 ? dt : 0 );
+}
+
+// eof
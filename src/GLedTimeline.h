@@ -0,0 +1,152 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       The GLedTimeline class plays synchronized sequences on several LEDs.
+// premises:	   ESP32 or ESP32 variant.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedTimeline.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_TIMELINE_HEADER_H
+#define GLED_TIMELINE_HEADER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include "GLed.h"
+
+#ifndef GLED_TIMELINE_MAX_TRACKS
+#define GLED_TIMELINE_MAX_TRACKS 16
+#endif
+#ifndef GLED_TIMELINE_MAX_KEYS
+#define GLED_TIMELINE_MAX_KEYS 64
+#endif
+
+/**
+ * A GLedTimeline plays a choreography on several LEDs, like a chaser,
+ * a knight rider or a progress bar. Each LED is a track. A track gets keyframes,
+ * which switch the LED on or off at a given time within the period of the timeline.
+ * \n
+ * The keyframes of all tracks are kept in one list sorted by time, which is
+ * executed by a single esp_timer. All keyframes falling on the same instant are
+ * applied with one batched gpio register write, so there is no skew between the LEDs.
+ * The times are computed from the start of the period, so no error accumulates.
+ * \n
+ * The LEDs must be activated with GLed::begin(). While the timeline is running
+ * the LEDs should not be switched by other means, e.g. by async_flash().
+ */
+class GLedTimeline {
+public:
+    static const unsigned MAX_TRACKS = GLED_TIMELINE_MAX_TRACKS;   ///< number of LEDs a timeline can control.
+    static const unsigned MAX_KEYS = GLED_TIMELINE_MAX_KEYS;       ///< number of keyframes of all tracks.
+    static const uint64_t PLAY_FOR_EVER = (uint64_t)(~0);          ///< number of periods to be played.
+
+    /**
+     * make an empty timeline.
+     * @param period_ms: duration of one period of the timeline (ms).
+     */
+    GLedTimeline( unsigned period_ms )
+        : n_tracks(0)
+        , n_keys(0)
+        , period(period_ms)
+        , count(0)
+        , running(false)
+        , cursor(0)
+        , cycle_start(0)
+        , timer(nullptr)
+    {};
+
+    ~GLedTimeline();
+
+    /**
+     * add a LED as a track.
+     * @param led: the LED to be controlled.
+     * @return the track number, or -1 if all tracks are used.
+     */
+    int add_track( GLed & led );
+
+    /**
+     * add a keyframe.
+     * @param track: track number returned by add_track().
+     * @param time_ms: time within the period (ms), must be less than the period.
+     * @param lightening: if true the LED is switched on, else off.
+     * @return false if the track or the time is invalid or all keyframes are used.
+     */
+    bool add_key( int track, unsigned time_ms, bool lightening );
+
+    /**
+     * add an on keyframe and the off keyframe dt_on later.
+     * An off time beyond the period wraps around to the beginning of the period.
+     * @param track: track number returned by add_track().
+     * @param time_ms: time within the period the LED is switched on (ms).
+     * @param dt_on: time during which the LED is ON (ms).
+     * @return false if the keyframes could not be added.
+     */
+    bool add_pulse( int track, unsigned time_ms, unsigned dt_on );
+
+    /**
+     * remove all tracks and keyframes. A running timeline gets stopped.
+     */
+    void clear();
+
+    /**
+     * start playing the timeline from the beginning.
+     * @param count: number of periods to be played.
+     * @return ESP_OK, ESP_ERR_INVALID_STATE if there are no keyframes,
+     *         otherwise the error code of the esp_timer.
+     */
+    esp_err_t start( uint64_t count = PLAY_FOR_EVER );
+
+    /**
+     * stop playing. The LEDs keep their current state.
+     */
+    void stop();
+
+    /**
+     * check if the timeline is playing.
+     */
+    bool is_running() const { return running; }
+
+    /**
+     * get the period of the timeline (ms).
+     */
+    unsigned get_period() const { return period; }
+
+private:
+    typedef struct {
+        uint32_t time;      ///< [ms] within the period.
+        uint8_t track;
+        bool lightening;
+    } keyframe_t;
+
+    GLed * tracks[MAX_TRACKS];
+    unsigned n_tracks;
+    keyframe_t keys[MAX_KEYS];
+    unsigned n_keys;
+    unsigned period;
+    volatile uint64_t count;
+    volatile bool running;
+    unsigned cursor;          ///< next keyframe to be applied.
+    int64_t cycle_start;      ///< start of the current period [us]
+    esp_timer_handle_t timer;
+
+    static void on_timer( void *arg );
+    void apply_instant();
+    void schedule_next();
+};
+
+#endif
+
+// eof
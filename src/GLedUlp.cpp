@@ -0,0 +1,248 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       flashing a LED by the ULP coprocessor during deep sleep.
+// premises:	   ESP32 with the ULP FSM coprocessor enabled.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedUlp.cpp
+// language:       C++
+// compiler:       g++ (Arduino IDE)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+
+#include <Arduino.h>
+
+#include "GLedUlp.h"
+
+#if CONFIG_IDF_TARGET_ESP32 && (CONFIG_ULP_COPROC_ENABLED || CONFIG_ESP32_ULP_COPROC_ENABLED)
+
+#include <sys/time.h>
+#include <esp_sleep.h>
+#include <esp32/ulp.h>
+#include <driver/rtc_io.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+
+static const char* TAG = "GLED";
+
+// RTC slow memory: data words of the program, followed by the program.
+enum { VAR_STATE, VAR_COUNT, VAR_WAIT, DATA_SIZE = 4 };
+static const uint32_t PROGRAM_ADDR = DATA_SIZE;
+
+// wake up period registers of the ULP timer:
+enum { PERIOD_OFF, PERIOD_ON, PERIOD_WAIT };
+
+// labels of the program:
+enum { LABEL_OFF, LABEL_HALT, LABEL_WAIT };
+
+// the flash sequence, kept during deep sleep:
+static RTC_DATA_ATTR bool ulp_running = false;
+static RTC_DATA_ATTR int ulp_pin = -1;
+static RTC_DATA_ATTR int64_t ulp_cycle_start = 0;   // system time [us] of an on edge.
+static RTC_DATA_ATTR uint64_t ulp_count = 0;        // count at ulp_cycle_start
+static RTC_DATA_ATTR uint32_t ulp_dt_on = 0;
+static RTC_DATA_ATTR uint32_t ulp_dt_off = 0;
+
+static int64_t system_time()
+{
+	struct timeval tv;
+
+	gettimeofday( &tv, nullptr );
+	return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+esp_err_t GLedUlp::start( GLed & led )
+{
+	if( ! led.activated || led.backend != nullptr )
+		return ESP_ERR_INVALID_STATE;
+
+	// the flash task owns the cursor of the base layer, stop it before reading:
+	led.stop_flash_task();
+
+	GLed::gled_layer_t & l = led.layers[0];
+	const GLedPattern * p = l.pattern;
+	if( p == nullptr || p->size() != 2 ) {   // the ULP knows on and off time only, no morse code.
+		ESP_LOGE( TAG, "LED (%d) ULP: no async_flash() to take over", led.pin );
+		if( p != nullptr )
+			led.start_flash_task( FLASH_TASK_CORE );
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	const TickType_t now = xTaskGetTickCount();
+	const bool restart = l.restart;
+	const unsigned step = restart ? 0 : l.step;
+	const TickType_t step_end = restart ? l.start + p->duration( 0 ) / portTICK_PERIOD_MS : l.step_end;
+	const int32_t wait_ticks = (int32_t) (step_end - now);
+	const uint32_t wait_us = wait_ticks > 0 ? wait_ticks * portTICK_PERIOD_MS * 1000 : 0;
+	const uint64_t count = GLed::api_count( l.count );
+
+	// the ULP counts a flash at its off edge, in the off step the one of the current cycle is over:
+	const uint64_t off_edges = step == 0 || count > GLedUlp::MAX_COUNT ? count : count - 1;
+
+	ulp_dt_on = p->duration( 0 );
+	ulp_dt_off = p->duration( 1 );
+	ulp_count = count;
+	ulp_cycle_start = system_time() + wait_us - (int64_t) (step == 0 ? ulp_dt_on : ulp_dt_on + ulp_dt_off) * 1000;
+
+	led.stop_layers();
+	led.activity_enabled = false;
+	if( off_edges == 0 ) {   // in the off time of the last flash, nothing left for the ULP.
+		ESP_LOGI( TAG, "LED (%d) ULP: the last flash is over", led.pin );
+		return ESP_OK;
+	}
+	return run( led, step == 0, off_edges, wait_us );
+}
+
+esp_err_t GLedUlp::start( GLed & led, uint64_t count, unsigned dt_on, unsigned dt_off )
+{
+	if( ! led.activated || led.backend != nullptr )
+		return ESP_ERR_INVALID_STATE;
+
+	led.stop_flash_task();
+	led.stop_layers();
+	led.activity_enabled = false;
+
+	ulp_dt_on = dt_on;
+	ulp_dt_off = dt_off;
+	ulp_count = count;
+	ulp_cycle_start = system_time();
+	return run( led, true, count, dt_on * 1000 );
+}
+
+esp_err_t GLedUlp::run( GLed & led, bool lightening, uint64_t off_edges, uint32_t wait_us )
+{
+	const gpio_num_t gpio = (gpio_num_t) led.pin;
+
+	if( ! rtc_gpio_is_valid_gpio( gpio ) )
+		return ESP_ERR_INVALID_ARG;
+
+	const int rtcio = rtc_io_number_get( gpio );
+	const bool on_level = led.on_is_high_level;
+	const uint32_t on_reg = on_level ? RTC_GPIO_OUT_W1TS_REG : RTC_GPIO_OUT_W1TC_REG;
+	const uint32_t off_reg = on_level ? RTC_GPIO_OUT_W1TC_REG : RTC_GPIO_OUT_W1TS_REG;
+	const uint32_t bit = RTC_GPIO_OUT_DATA_W1TS_S + rtcio;
+
+	// runs at each wake up of the ULP timer, the program counter restarts at the entry.
+	const ulp_insn_t program[] = {
+		I_MOVI( R3, 0 ),                        // base of the data words
+		I_LD( R0, R3, VAR_WAIT ),               // first run: wait until the next edge
+		M_BGE( LABEL_WAIT, 1 ),
+		I_LD( R0, R3, VAR_STATE ),
+		M_BGE( LABEL_OFF, 1 ),
+		I_WR_REG( on_reg, bit, bit, 1 ),        // switch on
+		I_MOVI( R0, 1 ),
+		I_ST( R0, R3, VAR_STATE ),
+		I_SLEEP_CYCLE_SEL( PERIOD_ON ),
+		I_HALT(),
+	M_LABEL( LABEL_OFF ),
+		I_WR_REG( off_reg, bit, bit, 1 ),       // switch off
+		I_MOVI( R0, 0 ),
+		I_ST( R0, R3, VAR_STATE ),
+		I_SLEEP_CYCLE_SEL( PERIOD_OFF ),
+		I_LD( R0, R3, VAR_COUNT ),              // 0 flashes for ever
+		M_BL( LABEL_HALT, 1 ),
+		I_SUBI( R0, R0, 1 ),
+		I_ST( R0, R3, VAR_COUNT ),
+		M_BGE( LABEL_HALT, 1 ),
+		I_END(),                                // the last flash: stop the timer
+	M_LABEL( LABEL_HALT ),
+		I_HALT(),
+	M_LABEL( LABEL_WAIT ),
+		I_MOVI( R0, 0 ),
+		I_ST( R0, R3, VAR_WAIT ),
+		I_SLEEP_CYCLE_SEL( PERIOD_WAIT ),
+		I_HALT(),
+	};
+
+	stop();
+
+	RTC_SLOW_MEM[VAR_STATE] = lightening ? 1 : 0;
+	RTC_SLOW_MEM[VAR_COUNT] = off_edges > GLedUlp::MAX_COUNT ? 0 : (uint32_t) off_edges;
+	RTC_SLOW_MEM[VAR_WAIT] = 1;
+
+	size_t size = sizeof(program) / sizeof(ulp_insn_t);
+	esp_err_t rc;
+	if( (rc = ulp_process_macros_and_load( PROGRAM_ADDR, program, &size )) != ESP_OK )
+		return rc;
+
+	// the RTC domain drives the pin from now on, with the current level:
+	rtc_gpio_init( gpio );
+	rtc_gpio_set_direction( gpio, RTC_GPIO_MODE_OUTPUT_ONLY );
+	rtc_gpio_set_level( gpio, lightening == on_level ? 1 : 0 );
+	esp_sleep_pd_config( ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON );
+
+	ulp_set_wakeup_period( PERIOD_OFF, ulp_dt_off * 1000 );
+	ulp_set_wakeup_period( PERIOD_ON, ulp_dt_on * 1000 );
+	ulp_set_wakeup_period( PERIOD_WAIT, wait_us > 0 ? wait_us : 1 );
+
+	ulp_pin = led.pin;
+	ulp_running = true;
+	ESP_LOGI( TAG, "LED (%d) flashed by the ULP: dt=(%u,%u), next edge in %u us", led.pin, ulp_dt_on, ulp_dt_off, wait_us );
+	return ulp_run( PROGRAM_ADDR );
+}
+
+void GLedUlp::stop()
+{
+	CLEAR_PERI_REG_MASK( RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN );
+}
+
+esp_err_t GLedUlp::resume( GLed & led, int core_num )
+{
+	if( ! ulp_running || led.pin != ulp_pin || led.backend != nullptr )
+		return ESP_ERR_INVALID_STATE;
+
+	stop();
+	ulp_running = false;
+	rtc_gpio_deinit( (gpio_num_t) led.pin );
+	pinMode( led.pin, OUTPUT );
+	led.refresh();
+
+	const int64_t period = (int64_t) (ulp_dt_on + ulp_dt_off) * 1000;
+	const int64_t elapsed = system_time() - ulp_cycle_start;
+	const uint64_t cycles = elapsed > 0 && period > 0 ? elapsed / period : 0;
+	const int64_t phase = elapsed > 0 && period > 0 ? elapsed % period : 0;
+
+	uint64_t count = ulp_count;
+	if( count <= GLedUlp::MAX_COUNT ) {
+		if( count <= cycles ) {   // expired during the sleep.
+			led.off();
+			return ESP_OK;
+		}
+		count -= cycles;
+	}
+
+	ESP_LOGI( TAG, "LED (%d) resumed from the ULP: %" PRIu64 " cycles, phase %u ms", led.pin, cycles, (unsigned) (phase / 1000) );
+
+	// continue with the cycle started phase ago:
+	if( ! led.play_flash( count, ulp_dt_on, ulp_dt_off, true, xTaskGetTickCount() - phase / 1000 / portTICK_PERIOD_MS ) )
+		return ESP_OK;   // overtaken by an async_flash() of another task.
+	return led.start_flash_task( core_num ) == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+bool GLedUlp::is_running()
+{
+	return ulp_running;
+}
+
+#else
+
+esp_err_t GLedUlp::start( GLed & ) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t GLedUlp::start( GLed &, uint64_t, unsigned, unsigned ) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t GLedUlp::resume( GLed &, int ) { return ESP_ERR_NOT_SUPPORTED; }
+bool GLedUlp::is_running() { return false; }
+esp_err_t GLedUlp::run( GLed &, bool, uint64_t, uint32_t ) { return ESP_ERR_NOT_SUPPORTED; }
+void GLedUlp::stop() {}
+
+#endif
+
+// eof
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Project:       ESP32 TOOLS
+//
+//  Subcomponent:  ESP32x Led Control
+/////////////////////////////////////////////////////////////////////////////
+//
+// abstract:       flashing a LED by the ULP coprocessor during deep sleep.
+// premises:	   ESP32 with the ULP FSM coprocessor enabled.
+// remarks:
+// history:
+// AUTHOR:         G.Kasper
+// contact:        info@georgkasper.de
+// copyright:      Georg Kasper
+// file:           GLedUlp.h
+// language:       C++
+// compiler:       g++ (for ex. the Arduino IDE compiler)
+//
+// REVIEW:
+/////////////////////////////////////////////////////////////////////////////
+//
+#ifndef GLED_ULP_HEADER_H
+#define GLED_ULP_HEADER_H
+
+#include <Arduino.h>
+
+#include "GLed.h"
+
+/**
+ * GLedUlp hands the flashing of one LED to the ULP coprocessor, so the LED keeps flashing
+ * while the main cores are in deep sleep. The ULP program wakes up by its timer at each edge,
+ * switches the RTC gpio and sleeps again, which costs a few microampere.
+ * \n
+ * The LED must be on a RTC capable gpio. The flash parameters and the start of the
+ * flash cycle are kept in RTC memory, the system time runs on during deep sleep.
+ * After the wake up resume() gives the LED back to the flash task of the GLed,
+ * which continues with the same phase and the remaining count.
+ * \n
+ * Only the ESP32 ULP FSM coprocessor is supported (CONFIG_ULP_COPROC_ENABLED),
+ * on other chips all methods return ESP_ERR_NOT_SUPPORTED.
+ * The ULP program uses the first 32 words of the RTC slow memory.
+ * \n
+ * Example:
+ * \code
+ * led.begin();
+ * if( GLedUlp::is_running() )      // woken up from deep sleep
+ *     GLedUlp::resume( led );
+ * else
+ *     led.async_flash( GLed::FLASH_FOR_EVER, 20, 1980 );
+ * ...
+ * GLedUlp::start( led );           // take over the running async_flash()
+ * esp_deep_sleep( 60000000 );
+ * \endcode
+ */
+class GLedUlp {
+public:
+    static const unsigned MAX_COUNT = 0xffff;   ///< higher counts flash for ever.
+
+    /**
+     * hand the running async_flash() sequence of a LED to the ULP, in phase and with the remaining count.
+     * @param led: an activated LED on a RTC gpio.
+     * @return ESP_OK, ESP_ERR_INVALID_STATE if the LED does not run async_flash(),
+     *         ESP_ERR_INVALID_ARG if the gpio is not a RTC gpio, ESP_ERR_NOT_SUPPORTED without ULP.
+     */
+    static esp_err_t start( GLed & led );
+
+    /**
+     * start a new flash sequence of a LED on the ULP, beginning with the on time.
+     * @param led: an activated LED on a RTC gpio.
+     * @param count: number of flashes, GLed::FLASH_FOR_EVER or above MAX_COUNT flashes for ever.
+     * @param dt_on: on time [ms]
+     * @param dt_off: off time [ms]
+     * @return ESP_OK, ESP_ERR_INVALID_ARG if the gpio is not a RTC gpio, ESP_ERR_NOT_SUPPORTED without ULP.
+     */
+    static esp_err_t start( GLed & led, uint64_t count, unsigned dt_on = GLed::DEFAULT_FLASH_ON_TIME, unsigned dt_off = GLed::DEFAULT_FLASH_OFF_TIME );
+
+    /**
+     * stop the ULP and continue the flash sequence by the flash task of the LED, in phase.
+     * The LED has to be activated by begin() before. If the sequence has expired meanwhile the LED is switched off.
+     * @param led: the LED given to start().
+     * @param core: core to run the flash task.
+     * @return ESP_OK, ESP_ERR_INVALID_STATE if the ULP does not flash this LED.
+     */
+    static esp_err_t resume( GLed & led, int core = FLASH_TASK_CORE );
+
+    /**
+     * check if the ULP flashes a LED, also after a wake up from deep sleep.
+     */
+    static bool is_running();
+
+private:
+    static esp_err_t run( GLed & led, bool lightening, uint64_t off_edges, uint32_t wait_us );
+    static void stop();
+};
+
+#endif
+
+// eof